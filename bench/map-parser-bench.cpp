@@ -0,0 +1,125 @@
+// map-parser-bench.cpp
+// Compares the MAP parser against the original std::regex implementation.
+//
+// Usage: mudap-map-parser-bench [map file] [iterations]
+// Run from the repository root to use tests/data/ura.map. Exits non-zero
+// if the two parsers disagree.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <string>
+
+#include <sdcc/map_parser.h>
+#include <sdcc/util.h>
+
+namespace {
+
+// The regex based parser map_parser replaced, kept as the reference.
+std::optional<sdcc::map_info> parse_regex(const std::string& path)
+{
+    auto lines = sdcc::util::read_lines(path);
+    if (!lines)
+        return std::nullopt;
+
+    sdcc::map_info data;
+
+    const std::regex segment_re(
+        R"(^\s*([A-Za-z0-9_.\$]+)\s+((?:0[xX])?[0-9A-Fa-f]{4,8})\s+((?:0[xX])?[0-9A-Fa-f]{4,8}).*\(([^)]*)\)\s*$)");
+    const std::regex symbol_re(
+        R"(^\s*((?:0[xX])?[0-9A-Fa-f]{4,8})\s+([^\s]+)(?:\s+([^\s]+))?\s*$)");
+
+    for (const auto& raw : *lines)
+    {
+        auto trimmed = sdcc::util::trim(raw);
+        if (trimmed.empty())
+            continue;
+
+        if (auto seg = sdcc::util::match(trimmed, segment_re))
+        {
+            sdcc::segment s;
+            s.name = (*seg)[0];
+            s.address = static_cast<uint32_t>(std::stoul((*seg)[1], nullptr, 16));
+            s.size = static_cast<uint32_t>(std::stoul((*seg)[2], nullptr, 16));
+            s.attributes = (*seg)[3];
+            data.segments.push_back(std::move(s));
+            continue;
+        }
+
+        if (auto sym = sdcc::util::match(trimmed, symbol_re))
+        {
+            if ((*sym)[0] == "Value" || (*sym)[1] == "Global")
+                continue;
+
+            sdcc::symbol s;
+            s.address = static_cast<uint32_t>(std::stoul((*sym)[0], nullptr, 16));
+            s.name = (*sym)[1];
+            s.area = (*sym)[2];
+            s.bank = 0;
+            data.symbols.push_back(std::move(s));
+        }
+    }
+    return data;
+}
+
+bool same(const sdcc::map_info& a, const sdcc::map_info& b)
+{
+    auto same_segment = [](const sdcc::segment& x, const sdcc::segment& y)
+    {
+        return x.name == y.name && x.address == y.address &&
+               x.size == y.size && x.attributes == y.attributes;
+    };
+    auto same_symbol = [](const sdcc::symbol& x, const sdcc::symbol& y)
+    {
+        return x.name == y.name && x.address == y.address &&
+               x.area == y.area && x.bank == y.bank;
+    };
+    return std::equal(a.segments.begin(), a.segments.end(),
+                      b.segments.begin(), b.segments.end(), same_segment) &&
+           std::equal(a.symbols.begin(), a.symbols.end(),
+                      b.symbols.begin(), b.symbols.end(), same_symbol);
+}
+
+template <typename F>
+double time_ms(int iterations, F&& parse)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        parse();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "tests/data/ura.map";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    auto reference = parse_regex(path);
+    auto scanned = sdcc::map_parser().parse(path);
+    if (!reference || !scanned)
+    {
+        std::cerr << "Failed to parse " << path << std::endl;
+        return 1;
+    }
+    if (!same(*reference, *scanned))
+    {
+        std::cerr << "Parsers disagree on " << path << std::endl;
+        return 1;
+    }
+
+    double regex_ms = time_ms(iterations, [&] { parse_regex(path); });
+    double scan_ms = time_ms(iterations, [&] { sdcc::map_parser().parse(path); });
+
+    std::cout << path << ": " << scanned->segments.size() << " segments, "
+              << scanned->symbols.size() << " symbols\n"
+              << "  regex   " << regex_ms << " ms\n"
+              << "  scanner " << scan_ms << " ms ("
+              << regex_ms / scan_ms << "x)" << std::endl;
+    return 0;
+}
@@ -162,10 +162,28 @@ namespace dap
         static set_instruction_breakpoints_request from(const request &req);
     };
 
-    // Step over. Step over one instruction.
+    // Data breakpoint info. Whether and how a variable can be watched.
+    struct data_breakpoint_info_request : public request
+    {
+        int variables_reference = 0;
+        std::string name;
+
+        static data_breakpoint_info_request from(const request &req);
+    };
+
+    // Set data breakpoints. Replace all data breakpoints.
+    struct set_data_breakpoints_request : public request
+    {
+        std::vector<json> breakpoints;
+
+        static set_data_breakpoints_request from(const request &req);
+    };
+
+    // Step over. Step over one line or instruction.
     struct next_request : public request
     {
         int thread_id = 0;
+        std::string granularity;
 
         static next_request from(const request &req);
     };
@@ -188,6 +206,31 @@ namespace dap
         static step_out_request from(const request &req);
     };
 
+    // Step back. Step backwards to the previous line or instruction.
+    struct step_back_request : public request
+    {
+        int thread_id = 0;
+        std::string granularity;
+
+        static step_back_request from(const request &req);
+    };
+
+    // Reverse continue. Run backwards to the previous breakpoint.
+    struct reverse_continue_request : public request
+    {
+        int thread_id = 0;
+
+        static reverse_continue_request from(const request &req);
+    };
+
+    // Pause. Suspend a running thread.
+    struct pause_request : public request
+    {
+        int thread_id = 0;
+
+        static pause_request from(const request &req);
+    };
+
     // Response generator.
     class response
     {
@@ -214,12 +257,19 @@ namespace dap
         // Add a handler to the chain.
         void add_handler(std::unique_ptr<request_handler> handler);
 
-        // Set the callback for sending async events to the client.
-        void set_event_sender(std::function<void(const std::string &)> sender);
-
         // Run DAP server on the given streams.
         void run(std::istream &in, std::ostream &out);
 
+        // Send an event on the output stream of the running server.
+        // Safe to call from any thread; events never interleave with
+        // responses and are held back until the current request's
+        // response has been written.
+        void send_event(const std::string &json);
+        // Like send_event, but gives up and returns false instead of
+        // waiting while a request is being handled. For threads a request
+        // handler may be waiting on.
+        bool try_send_event(const std::string &json);
+
     private:
         std::string handle_message(const std::string &json);
         std::string read_message(std::istream &in);
@@ -228,7 +278,8 @@ namespace dap
     private:
         std::vector<std::unique_ptr<request_handler>> handlers_;
         std::mutex mutex_;
-        std::function<void(const std::string &)> send_event_;
+        std::recursive_mutex write_mutex_;
+        std::ostream *out_ = nullptr;
     };
 
 } // namespace dap
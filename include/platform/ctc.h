@@ -0,0 +1,74 @@
+// ctc.h
+// Z80 CTC counter/timer, four channels on four consecutive ports.
+//
+// Timer mode channels count down once every 16 or 256 T-states (the
+// prescaler) and reload from their time constant at zero. The counter is
+// not ticked per instruction: a channel remembers the T-state it started
+// at and works its current value out from the clock when it is read. With
+// interrupts enabled, a scheduler timer fires at each zero count and
+// requests the channel's interrupt (vector + 2n for channel n).
+// Counter mode channels count edges on their CLK/TRG input, which nothing
+// drives, so they hold their time constant.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include <platform/interrupts.h>
+#include <platform/io_bus.h>
+#include <platform/scheduler.h>
+
+namespace platform {
+
+class ctc : public io_device
+{
+public:
+    static constexpr unsigned port_count = 4;
+
+    // Channel control word bits.
+    static constexpr uint8_t control = 0x01;
+    static constexpr uint8_t reset = 0x02;
+    static constexpr uint8_t time_constant_follows = 0x04;
+    static constexpr uint8_t prescaler_256 = 0x20;
+    static constexpr uint8_t counter_mode = 0x40;
+    static constexpr uint8_t interrupt_enable = 0x80;
+
+    // Registers the four channels with `interrupts`, channel 0 first.
+    ctc(scheduler &clock, interrupt_chain &interrupts);
+
+    uint8_t read(uint8_t offset) override;
+    void write(uint8_t offset, uint8_t value) override;
+    // Loading re-arms the zero count timers from the restored clock.
+    void save(state_writer &out) const override;
+    void load(state_reader &in) override;
+
+    // Interrupt vector for channel 0; channel n uses vector + 2n.
+    uint8_t vector() const { return vector_; }
+
+private:
+    struct channel {
+        uint8_t control = reset;
+        uint8_t time_constant = 0;  // 0 means 256.
+        bool loading = false;       // Next write is the time constant.
+        bool running = false;
+        uint64_t start = 0;         // T-state the count (re)started.
+        unsigned source = 0;        // Interrupt chain source.
+        std::optional<scheduler::timer> zero;
+    };
+
+    // T-states per count, and from one zero count to the next.
+    unsigned period(const channel &ch) const;
+    uint64_t cycle(const channel &ch) const;
+    void schedule(unsigned index);
+    void zero_count(unsigned index, uint64_t at);
+
+    scheduler &clock_;
+    interrupt_chain &interrupts_;
+    std::array<channel, 4> channels_;
+    uint8_t vector_ = 0;
+};
+
+} // namespace platform
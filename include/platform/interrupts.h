@@ -0,0 +1,91 @@
+// interrupts.h
+// Z80 interrupt lines: a maskable INT daisy chain and NMI.
+//
+// Sources are numbered in daisy chain order as devices register them, so
+// the first device attached has the highest priority. A request stays
+// pending until the CPU accepts it, which acknowledges the highest
+// priority source and, in interrupt mode 2, reads its vector. The
+// in-service state that RETI clears on real daisy chains isn't modelled:
+// a lower priority source can interrupt a handler as soon as it re-enables
+// interrupts.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include <platform/state.h>
+
+namespace platform {
+
+class interrupt_chain
+{
+public:
+    static constexpr unsigned max_sources = 64;
+
+    // Returns the new source's number, or max_sources if the chain is
+    // full (requests from it are then ignored).
+    unsigned add_source()
+    {
+        return sources_ < max_sources ? sources_++ : max_sources;
+    }
+    void reset()
+    {
+        sources_ = 0;
+        pending_ = 0;
+        nmi_ = false;
+    }
+
+    void request(unsigned source, uint8_t vector)
+    {
+        if (source >= max_sources)
+            return;
+        vectors_[source] = vector;
+        pending_ |= uint64_t{1} << source;
+    }
+    void cancel(unsigned source)
+    {
+        if (source < max_sources)
+            pending_ &= ~(uint64_t{1} << source);
+    }
+    void request_nmi() { nmi_ = true; }
+
+    // Checked by the CPU loop after every instruction.
+    bool pending() const { return pending_ != 0 || nmi_; }
+    bool int_pending() const { return pending_ != 0; }
+    bool nmi_pending() const { return nmi_; }
+
+    // Vector of the highest priority request (the bus floats to 0xFF
+    // when there is none).
+    uint8_t vector() const
+    {
+        return pending_ ? vectors_[std::countr_zero(pending_)] : 0xFF;
+    }
+    // The CPU accepted INT: the highest priority request is served.
+    void acknowledge() { pending_ &= pending_ - 1; }
+    void acknowledge_nmi() { nmi_ = false; }
+
+    // Pending requests; the sources stay as registered.
+    void save(state_writer &out) const
+    {
+        out.put(pending_);
+        out.put(nmi_);
+        out.put(vectors_);
+    }
+    void load(state_reader &in)
+    {
+        pending_ = in.get<uint64_t>();
+        nmi_ = in.get<bool>();
+        vectors_ = in.get<std::array<uint8_t, max_sources>>();
+    }
+
+private:
+    unsigned sources_ = 0;
+    uint64_t pending_ = 0;
+    bool nmi_ = false;
+    std::array<uint8_t, max_sources> vectors_{};
+};
+
+} // namespace platform
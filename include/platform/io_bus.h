@@ -0,0 +1,75 @@
+// io_bus.h
+// Z80 I/O port bus with a dispatch table.
+//
+// Devices attach to ranges of ports. The bus keeps one table entry per
+// port, so every IN and OUT is a single indexed virtual call no matter how
+// many devices are attached; ports nobody claims go to an open bus device
+// that reads 0xFF and ignores writes. Ports are decoded on their low byte,
+// like most Z80 boards (the high byte is B or A during IN/OUT).
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include <platform/state.h>
+
+namespace platform {
+
+// A peripheral on the I/O bus. `offset` is the port relative to the first
+// port of the range the device was attached to. Devices with state of
+// their own save it for machine snapshots; load() gets back what save()
+// wrote, on the same machine, with the clock already restored.
+class io_device
+{
+public:
+    virtual ~io_device() = default;
+    virtual uint8_t read(uint8_t offset) = 0;
+    virtual void write(uint8_t offset, uint8_t value) = 0;
+    virtual void save(state_writer &) const {}
+    virtual void load(state_reader &) {}
+};
+
+class io_bus
+{
+public:
+    io_bus();
+    io_bus(const io_bus &) = delete;
+    io_bus &operator=(const io_bus &) = delete;
+
+    // Route ports [first, first + count) to `device`, which must outlive
+    // the attachment. Returns false if any of them is taken already or
+    // the range runs past port 0xFF.
+    bool attach(uint8_t first, unsigned count, io_device &device);
+    // Return every port to the open bus.
+    void detach_all();
+
+    uint8_t read(uint16_t port)
+    {
+        const auto &e = ports_[port & 0xFF];
+        return e.device->read(e.offset);
+    }
+    void write(uint16_t port, uint8_t value)
+    {
+        const auto &e = ports_[port & 0xFF];
+        e.device->write(e.offset, value);
+    }
+
+private:
+    class open_bus : public io_device
+    {
+    public:
+        uint8_t read(uint8_t) override { return 0xFF; }
+        void write(uint8_t, uint8_t) override {}
+    };
+
+    struct entry {
+        io_device *device;
+        uint8_t offset;
+    };
+    open_bus open_bus_;
+    std::array<entry, 256> ports_;
+};
+
+} // namespace platform
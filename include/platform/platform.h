@@ -0,0 +1,67 @@
+// platform.h
+// Machine profiles: the memory layout, bank registers, devices and clock
+// of the board a program runs on.
+//
+// A profile is a plain description. The launch handler applies it once,
+// building the memory page tables and the I/O dispatch table from it, so
+// nothing in the CPU loop looks at the profile again. Profiles are
+// compiled in, one per subdirectory of lib/platform, and picked by name
+// with the "platform" launch argument; the "memory" and "devices" launch
+// arguments replace the corresponding parts of the chosen profile.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace platform {
+
+enum class device_type { sio, ctc };
+
+// CPU addresses [address, address + size), page aligned.
+struct memory_range {
+    uint16_t address = 0;
+    uint32_t size = 0;
+};
+
+// A bank switched window and the port of its bank select register.
+struct bank_window {
+    memory_range range;
+    uint8_t port = 0;
+};
+
+// A device on the I/O bus, `port` being the first of its range. Devices
+// join the interrupt daisy chain in the order listed.
+struct device {
+    device_type type = device_type::sio;
+    uint8_t port = 0;
+};
+
+struct profile {
+    std::string_view name;
+    std::string_view description;
+    uint32_t clock_hz = 4000000;
+    unsigned banks = 1;                 // 64K banks of physical memory.
+    std::optional<memory_range> rom;    // Writes are ignored.
+    std::vector<bank_window> windows;
+    std::vector<device> devices;
+};
+
+// Name of a device type, as used by the "devices" launch argument.
+std::string_view device_name(device_type type);
+std::optional<device_type> find_device_type(std::string_view name);
+
+// Every compiled-in profile, the default ("none") first.
+std::span<const profile *const> profiles();
+// The profile called `name`, or nullptr.
+const profile *find_profile(std::string_view name);
+
+// Defined by the platform subdirectories.
+namespace none { const profile &machine(); }
+namespace partner { const profile &machine(); }
+
+} // namespace platform
@@ -0,0 +1,97 @@
+// scheduler.h
+// T-state clock and event scheduler for device timing.
+//
+// The CPU loop advances the clock by the T-states of every instruction
+// and only has to compare it with the time of the earliest pending event,
+// so time costs one compare per instruction when nothing is due. Events
+// are kept in a min-heap keyed on the T-state they are due at.
+//
+// Devices own timers. Re-arming or cancelling a timer doesn't search the
+// heap: each timer carries a generation number, and heap entries from an
+// older generation are dropped when they reach the top.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace platform {
+
+class scheduler
+{
+public:
+    class timer;
+
+    scheduler() = default;
+    scheduler(const scheduler &) = delete;
+    scheduler &operator=(const scheduler &) = delete;
+
+    uint64_t now() const { return now_; }
+    void advance(unsigned tstates) { now_ += tstates; }
+    // Set the clock when restoring a machine state. Pending timers keep
+    // their due times; their owners re-arm them as they restore.
+    void set_now(uint64_t t) { now_ = t; }
+    // Something is due: call run_due().
+    bool due() const { return now_ >= next_; }
+    // Fire every timer due by now(), earliest first.
+    void run_due();
+    // T-state of the earliest pending event (max if none).
+    uint64_t next() const { return next_; }
+
+    // CPU clock in Hz, for converting T-states to time.
+    uint32_t frequency() const { return frequency_; }
+    void set_frequency(uint32_t hz) { frequency_ = hz; }
+
+private:
+    struct entry {
+        uint64_t at;
+        uint32_t slot;
+        uint32_t generation;
+    };
+    struct slot {
+        timer *owner = nullptr;
+        uint32_t generation = 0;
+    };
+
+    uint32_t add_timer(timer *owner);
+    void remove_timer(uint32_t slot);
+    void push(uint64_t at, uint32_t slot);
+    void compact();
+
+    uint64_t now_ = 0;
+    uint64_t next_ = std::numeric_limits<uint64_t>::max();
+    uint32_t frequency_ = 4000000;
+    std::vector<entry> heap_;
+    std::vector<slot> slots_;
+    std::vector<uint32_t> free_slots_;
+    size_t armed_ = 0;
+};
+
+// A single pending event. The callback gets the T-state the event was due
+// at (which may be a few T-states before now()), so periodic devices can
+// re-arm from it without drifting.
+class scheduler::timer
+{
+public:
+    timer(scheduler &clock, std::function<void(uint64_t)> fire);
+    ~timer();
+    timer(const timer &) = delete;
+    timer &operator=(const timer &) = delete;
+
+    // Fire at T-state `at`, replacing any pending event of this timer.
+    void arm(uint64_t at);
+    void cancel();
+    bool armed() const { return armed_; }
+
+private:
+    friend class scheduler;
+    scheduler &clock_;
+    uint32_t slot_;
+    bool armed_ = false;
+    std::function<void(uint64_t)> fire_;
+};
+
+} // namespace platform
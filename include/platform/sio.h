@@ -0,0 +1,51 @@
+// sio.h
+// Console character device modelled on one channel of a Z80 SIO.
+//
+// Two ports: data (offset 0) and control (offset 1). Bytes written to the
+// data port go to the output callback straight away; there is no baud
+// rate, so the transmitter is always empty. Input is queued by the host
+// with receive() and read from the data port one byte at a time.
+//
+// The control port follows the SIO register pointer protocol closely
+// enough for the usual initialisation code: a write to WR0 selects the
+// register for the next control access, RR0 reports receive character
+// available (bit 0) and transmit buffer empty (bit 2), RR1 all sent and
+// RR2 the interrupt vector written to WR2.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string_view>
+
+#include <platform/io_bus.h>
+
+namespace platform {
+
+class sio : public io_device
+{
+public:
+    static constexpr unsigned port_count = 2;
+
+    explicit sio(std::function<void(uint8_t)> output);
+
+    uint8_t read(uint8_t offset) override;
+    void write(uint8_t offset, uint8_t value) override;
+    void save(state_writer &out) const override;
+    void load(state_reader &in) override;
+
+    // Queue host input for the program. Like every device access from
+    // outside the CPU loop, only call this while execution is parked.
+    void receive(std::string_view text);
+
+private:
+    std::function<void(uint8_t)> output_;
+    std::deque<uint8_t> input_;
+    std::array<uint8_t, 8> wr_{};
+    uint8_t pointer_ = 0;
+};
+
+} // namespace platform
@@ -0,0 +1,95 @@
+// state.h
+// Flat byte streams for saving and restoring device state.
+//
+// Machine snapshots (reverse execution, saved states) store every device
+// as the bytes its save() writes, and hand the same bytes back to load()
+// on an identical machine. Values are copied as they are in memory: the
+// blobs are only meant to be read back by the same build.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace platform {
+
+class state_writer
+{
+public:
+    explicit state_writer(std::vector<uint8_t> &out) : out_(out) {}
+
+    template <typename T>
+    void put(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        bytes(&value, sizeof value);
+    }
+    void bytes(const void *data, size_t size)
+    {
+        const auto *p = static_cast<const uint8_t *>(data);
+        out_.insert(out_.end(), p, p + size);
+    }
+
+private:
+    std::vector<uint8_t> &out_;
+};
+
+// Reads past the end yield zeroes and clear ok().
+class state_reader
+{
+public:
+    state_reader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+    explicit state_reader(const std::vector<uint8_t> &in)
+        : state_reader(in.data(), in.size()) {}
+
+    template <typename T>
+    T get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        bytes(&value, sizeof value);
+        return value;
+    }
+    void bytes(void *data, size_t size)
+    {
+        if (size > size_ - offset_)
+        {
+            std::memset(data, 0, size);
+            offset_ = size_;
+            ok_ = false;
+            return;
+        }
+        if (size)
+            std::memcpy(data, data_ + offset_, size);
+        offset_ += size;
+    }
+
+    // The next `size` bytes in place, or nullptr (and !ok()) if there
+    // aren't that many.
+    const uint8_t *skip(size_t size)
+    {
+        if (size > size_ - offset_)
+        {
+            offset_ = size_;
+            ok_ = false;
+            return nullptr;
+        }
+        offset_ += size;
+        return data_ + offset_ - size;
+    }
+
+    bool ok() const { return ok_; }
+    size_t remaining() const { return size_ - offset_; }
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t offset_ = 0;
+    bool ok_ = true;
+};
+
+} // namespace platform
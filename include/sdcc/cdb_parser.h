@@ -9,6 +9,9 @@
 // MIT License.
 #pragma once
 
+#include <string_view>
+#include <unordered_map>
+
 #include <sdcc/parser.h>
 #include <sdcc/cdbg_info.h>
 
@@ -26,9 +29,32 @@ private:
     void parse_symbol(std::string_view content);
     void parse_type(std::string_view content);
     void parse_line_info(std::string_view content);
+    void parse_function_address(std::string_view content);
+
+    // Hash maps keyed by std::string that can be probed with a
+    // std::string_view without building a temporary string.
+    struct name_hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const {
+            return std::hash<std::string_view>{}(s);
+        }
+    };
+    template<typename V>
+    using name_map = std::unordered_map<std::string, V, name_hash, std::equal_to<>>;
+
+    cdbg_info_module* find_module(std::string_view name);
+    cdbg_info_function* find_function(size_t module, std::string_view name);
+
+    // Index into data_ of the current module for assigning functions,
+    // symbols, etc. (npos before the first M: record).
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    size_t current_module_ = npos;
 
-    // Track current module for assigning functions, symbols, etc.
-    std::string current_module_;
+    // Name -> index of the first module / function with that name, so
+    // records don't search data_ linearly.
+    name_map<size_t> modules_;
+    std::vector<name_map<size_t>> functions_; // Parallel to data_
+    name_map<std::pair<size_t, size_t>> global_functions_;
 };
 
 } // namespace sdcc
\ No newline at end of file
@@ -25,6 +25,11 @@ namespace sdcc {
         std::string name; // Function name (e.g., "clock_init")
         std::string scope; // "global" or "local"
         std::vector<cdbg_info_symbol> local_symbols; // Local variables
+        int stack = 0; // Frame size from the F: record (e.g. -6)
+        bool interrupt = false; // Interrupt service routine
+        bool has_range = false; // Entry address was found in L: records
+        uint32_t start = 0; // Entry address (L:G$/L:F record)
+        uint32_t end = 0; // Address of the last instruction (L:XG$/L:XF)
     };
 
     struct cdbg_info_type {
@@ -36,7 +41,7 @@ namespace sdcc {
     struct cdbg_info_line {
         std::string file; // Source file path (e.g., "clock.c")
         int line = 0; // Line number
-        uint16_t address = 0; // Mapped memory address
+        uint32_t address = 0; // Mapped memory address (bank in bits 16+)
         std::string scope; // "global" or "local"
     };
 
@@ -0,0 +1,61 @@
+// debug_cache.h
+// Persistent binary cache of parsed SDCC debug information.
+//
+// This file declares the debug_cache class, which stores the modules
+// parsed from a CDB file and the segments and symbols parsed from a MAP
+// file in one compact binary file, so relaunching the same program skips
+// the text parsers. The cache records the size, modification time and
+// content hash of both source files and is only used while they match.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include <sdcc/cdbg_info.h>
+#include <sdcc/map_parser.h>
+
+namespace sdcc {
+
+// Everything the cache holds. A missing or unparsable source file is
+// stored as absent and must still be absent when the cache is loaded.
+struct debug_info {
+    bool has_cdb = false;
+    std::vector<cdbg_info_module> modules;
+    bool has_map = false;
+    map_info map;
+};
+
+// Identity of a source file when the cache was written.
+struct file_stamp {
+    bool exists = false;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0; // FNV-1a of the content, checked when mtime differs
+};
+
+class debug_cache {
+public:
+    explicit debug_cache(std::string path) : path_(std::move(path)) {}
+
+    // Returns the cached debug info if the cache exists, is intact and
+    // both source files still match their recorded stamps. A source whose
+    // modification time changed but whose content hash still matches is
+    // accepted, and its new time is written back to the cache.
+    std::optional<debug_info> load(const std::string& cdb_path,
+                                   const std::string& map_path) const;
+    // Writes the cache for the given source files, false on I/O error.
+    bool save(const debug_info& info, const std::string& cdb_path,
+              const std::string& map_path) const;
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+} // namespace sdcc
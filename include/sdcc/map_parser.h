@@ -9,6 +9,8 @@
 #pragma once
 
 #include <optional>
+#include <string>
+#include <vector>
 
 #include <sdcc/segment.h>
 #include <sdcc/symbol.h>
@@ -22,6 +24,7 @@ struct map_info {
 
 class map_parser {
 public:
+    // Moves the result out; data() is empty afterwards.
     std::optional<map_info> parse(const std::string& path);
     const map_info& data() const { return data_; }
 
@@ -33,7 +33,9 @@ namespace sdcc {
         std::optional<std::vector<T>> parse(const std::string& path) override {
             data_.clear();
             if (do_parse(path)) {
-                return data_;
+                // Hand the result over instead of copying it; data() is
+                // empty afterwards.
+                return std::move(data_);
             }
             return std::nullopt;
         }
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 namespace sdcc {
@@ -20,4 +21,13 @@ namespace sdcc {
         std::string area;
         int bank = 0;
     };
+
+    // Display preference for symbols sharing an address (lower is better):
+    // C names, then plain assembler labels, then SDCC debug names (G$...,
+    // F<module>$... for statics, L$...), then s__<area> starts. C$/A$ line
+    // markers, XG$/XF<module>$ function end markers and l__<area> lengths
+    // are not labels at all.
+    enum symbol_rank_value { rank_c, rank_label, rank_debug, rank_area, rank_none };
+
+    symbol_rank_value symbol_rank(std::string_view name);
 }
\ No newline at end of file
@@ -14,14 +14,53 @@
 #include <string_view>
 #include <regex>
 #include <optional>
+#include <charconv>
+#include <fstream>
+#include <cstring>
 
 namespace sdcc::util {
     // Read all lines from a file, returning empty optional on error
     std::optional<std::vector<std::string>> read_lines(const std::string& path);
+    // Stream a file through a reused buffer, calling fn for every line
+    // (without the '\n'); false if the file can't be opened
+    template<typename F>
+    bool for_each_line(const std::string& path, F&& fn) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::vector<char> buffer(64 * 1024);
+        size_t filled = 0; // Bytes of an unfinished line at the front
+        while (true) {
+            file.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+            std::string_view chunk(buffer.data(), filled + static_cast<size_t>(file.gcount()));
+            size_t start = 0;
+            for (size_t eol; (eol = chunk.find('\n', start)) != std::string_view::npos; start = eol + 1) {
+                fn(chunk.substr(start, eol - start));
+            }
+            if (!file) {
+                if (start < chunk.size()) {
+                    fn(chunk.substr(start));
+                }
+                return true;
+            }
+            filled = chunk.size() - start;
+            std::memmove(buffer.data(), buffer.data() + start, filled);
+            if (filled == buffer.size()) {
+                buffer.resize(buffer.size() * 2); // Line longer than the buffer
+            }
+        }
+    }
     // Trim whitespace from both ends of a string_view
     std::string_view trim(std::string_view str);
     // Split a string_view by delimiter, returning trimmed parts
     std::vector<std::string_view> split(std::string_view str, char delim);
+    // Parse a number at the start of a string_view, false on error
+    template<typename T>
+    bool to_number(std::string_view str, T& value, int base = 10) {
+        auto result = std::from_chars(str.data(), str.data() + str.size(), value, base);
+        return result.ec == std::errc();
+    }
     // Parse a line using a regex, returning matched groups
     std::optional<std::vector<std::string>> match(std::string_view line, const std::regex& pattern);
 }
\ No newline at end of file
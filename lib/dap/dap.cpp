@@ -44,11 +44,6 @@ namespace dap
         return resp.str();
     }
 
-    void dap::set_event_sender(std::function<void(const std::string &)> sender)
-    {
-        send_event_ = std::move(sender);
-    }
-
     std::string dap::read_message(std::istream &in)
     {
         std::string header;
@@ -82,8 +77,30 @@ namespace dap
         out.flush();
     }
 
+    void dap::send_event(const std::string &json)
+    {
+        std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+        if (out_)
+            send_message(*out_, json);
+    }
+
+    bool dap::try_send_event(const std::string &json)
+    {
+        std::unique_lock<std::recursive_mutex> lock(write_mutex_, std::try_to_lock);
+        if (!lock.owns_lock())
+            return false;
+        if (out_)
+            send_message(*out_, json);
+        return true;
+    }
+
     void dap::run(std::istream &in, std::ostream &out)
     {
+        {
+            std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+            out_ = &out;
+        }
+
         while (true)
         {
             std::string req_json = read_message(in);
@@ -91,12 +108,19 @@ namespace dap
 
             std::cout << "\n[RECEIVED] " << req_json << "\n";
 
+            // Hold the write lock across handling so that events raised
+            // by other threads (e.g. the execution thread) can't overtake
+            // the response. Handlers sending events inline re-enter it.
+            std::lock_guard<std::recursive_mutex> lock(write_mutex_);
             std::string resp_json = handle_message(req_json);
             if (!resp_json.empty()) {
                 std::cout << "[RESPONSE] " << resp_json << "\n";
                 send_message(out, resp_json);
             }
         }
+
+        std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+        out_ = nullptr;
     }
 
 } // namespace dap
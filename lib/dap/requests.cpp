@@ -155,6 +155,7 @@ namespace dap
     {
         next_request r = base_copy<next_request>(req);
         r.thread_id = req.arguments.value("threadId", 0);
+        r.granularity = req.arguments.value("granularity", "");
         return r;
     }
 
@@ -174,6 +175,28 @@ namespace dap
         return r;
     }
 
+    step_back_request step_back_request::from(const request &req)
+    {
+        step_back_request r = base_copy<step_back_request>(req);
+        r.thread_id = req.arguments.value("threadId", 0);
+        r.granularity = req.arguments.value("granularity", "");
+        return r;
+    }
+
+    reverse_continue_request reverse_continue_request::from(const request &req)
+    {
+        reverse_continue_request r = base_copy<reverse_continue_request>(req);
+        r.thread_id = req.arguments.value("threadId", 0);
+        return r;
+    }
+
+    pause_request pause_request::from(const request &req)
+    {
+        pause_request r = base_copy<pause_request>(req);
+        r.thread_id = req.arguments.value("threadId", 0);
+        return r;
+    }
+
     set_instruction_breakpoints_request set_instruction_breakpoints_request::from(const request &req)
     {
         set_instruction_breakpoints_request r = base_copy<set_instruction_breakpoints_request>(req);
@@ -181,4 +204,19 @@ namespace dap
         return r;
     }
 
+    data_breakpoint_info_request data_breakpoint_info_request::from(const request &req)
+    {
+        data_breakpoint_info_request r = base_copy<data_breakpoint_info_request>(req);
+        r.variables_reference = req.arguments.value("variablesReference", 0);
+        r.name = req.arguments.value("name", "");
+        return r;
+    }
+
+    set_data_breakpoints_request set_data_breakpoints_request::from(const request &req)
+    {
+        set_data_breakpoints_request r = base_copy<set_data_breakpoints_request>(req);
+        r.breakpoints = req.arguments.value("breakpoints", std::vector<json>{});
+        return r;
+    }
+
 } // namespace dap
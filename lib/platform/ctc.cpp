@@ -0,0 +1,121 @@
+// ctc.cpp
+// Z80 CTC counter/timer, four channels on four consecutive ports.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <platform/ctc.h>
+
+namespace platform {
+
+ctc::ctc(scheduler &clock, interrupt_chain &interrupts)
+    : clock_(clock), interrupts_(interrupts)
+{
+    for (unsigned i = 0; i < channels_.size(); ++i)
+    {
+        channels_[i].source = interrupts_.add_source();
+        channels_[i].zero.emplace(clock_, [this, i](uint64_t at) { zero_count(i, at); });
+    }
+}
+
+unsigned ctc::period(const channel &ch) const
+{
+    return (ch.control & prescaler_256) ? 256 : 16;
+}
+
+uint64_t ctc::cycle(const channel &ch) const
+{
+    return uint64_t{period(ch)} * (ch.time_constant ? ch.time_constant : 256);
+}
+
+uint8_t ctc::read(uint8_t offset)
+{
+    const auto &ch = channels_[offset & 3];
+    unsigned constant = ch.time_constant ? ch.time_constant : 256;
+    if (!ch.running || (ch.control & counter_mode))
+        return ch.time_constant;
+
+    uint64_t counts = (clock_.now() - ch.start) / period(ch);
+    return static_cast<uint8_t>(constant - counts % constant);
+}
+
+void ctc::write(uint8_t offset, uint8_t value)
+{
+    unsigned index = offset & 3;
+    auto &ch = channels_[index];
+    if (ch.loading)
+    {
+        // Loading the time constant (re)starts the count.
+        ch.time_constant = value;
+        ch.loading = false;
+        ch.running = true;
+        ch.start = clock_.now();
+        schedule(index);
+        return;
+    }
+
+    if (!(value & control))
+    {
+        // Interrupt vector, only written through channel 0.
+        if (index == 0)
+            vector_ = value & 0xF8;
+        return;
+    }
+
+    ch.control = value;
+    ch.loading = (value & time_constant_follows) != 0;
+    if (value & reset)
+        ch.running = false;
+    schedule(index);
+}
+
+void ctc::save(state_writer &out) const
+{
+    for (const auto &ch : channels_)
+    {
+        out.put(ch.control);
+        out.put(ch.time_constant);
+        out.put(ch.loading);
+        out.put(ch.running);
+        out.put(ch.start);
+    }
+    out.put(vector_);
+}
+
+void ctc::load(state_reader &in)
+{
+    for (auto &ch : channels_)
+    {
+        ch.control = in.get<uint8_t>();
+        ch.time_constant = in.get<uint8_t>();
+        ch.loading = in.get<bool>();
+        ch.running = in.get<bool>();
+        ch.start = in.get<uint64_t>();
+    }
+    vector_ = in.get<uint8_t>();
+    for (unsigned i = 0; i < channels_.size(); ++i)
+        schedule(i);
+}
+
+// Arm the channel's timer for its next zero count, if it interrupts.
+void ctc::schedule(unsigned index)
+{
+    auto &ch = channels_[index];
+    if (!ch.running || (ch.control & counter_mode) || !(ch.control & interrupt_enable))
+    {
+        ch.zero->cancel();
+        interrupts_.cancel(ch.source);
+        return;
+    }
+    uint64_t elapsed = clock_.now() - ch.start;
+    uint64_t cycles = elapsed / cycle(ch) + 1;
+    ch.zero->arm(ch.start + cycles * cycle(ch));
+}
+
+void ctc::zero_count(unsigned index, uint64_t at)
+{
+    auto &ch = channels_[index];
+    interrupts_.request(ch.source, static_cast<uint8_t>(vector_ | (index << 1)));
+    ch.zero->arm(at + cycle(ch));
+}
+
+} // namespace platform
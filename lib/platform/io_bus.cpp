@@ -0,0 +1,34 @@
+// io_bus.cpp
+// Z80 I/O port bus with a dispatch table.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <platform/io_bus.h>
+
+namespace platform {
+
+io_bus::io_bus()
+{
+    detach_all();
+}
+
+bool io_bus::attach(uint8_t first, unsigned count, io_device &device)
+{
+    if (count == 0 || first + count > ports_.size())
+        return false;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (ports_[first + i].device != &open_bus_)
+            return false;
+    }
+    for (unsigned i = 0; i < count; ++i)
+        ports_[first + i] = {&device, static_cast<uint8_t>(i)};
+    return true;
+}
+
+void io_bus::detach_all()
+{
+    ports_.fill({&open_bus_, 0});
+}
+
+} // namespace platform
@@ -0,0 +1,25 @@
+// none.cpp
+// The default machine: a bare Z80 with 64K of RAM and nothing on the I/O
+// bus, which is what programs ran on before profiles existed.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <platform/platform.h>
+
+namespace platform::none {
+
+const profile &machine()
+{
+    static const profile p = {
+        .name = "none",
+        .description = "Z80, 64K RAM, no devices",
+        .clock_hz = 4000000,
+        .banks = 1,
+        .rom = std::nullopt,
+        .windows = {},
+        .devices = {},
+    };
+    return p;
+}
+
+} // namespace platform::none
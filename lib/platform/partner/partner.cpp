@@ -0,0 +1,35 @@
+// partner.cpp
+// Iskra Delta Partner running banked CP/M 3.
+//
+// A 4 MHz Z80 with 128K of RAM. The lower 48K is switched between the two
+// 64K banks and the top 16K is common memory, where CP/M 3 keeps the
+// resident BDOS and BIOS. The boot ROM is switched out by the time CP/M
+// runs, so there is no ROM. The console is the first SIO channel, and the
+// CTC provides the system tick.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <platform/platform.h>
+
+namespace platform::partner {
+
+const profile &machine()
+{
+    static const profile p = {
+        .name = "partner",
+        .description = "Iskra Delta Partner, banked CP/M 3",
+        .clock_hz = 4000000,
+        .banks = 2,
+        .rom = std::nullopt,
+        .windows = {
+            {{0x0000, 0xC000}, 0x88},
+        },
+        .devices = {
+            {device_type::ctc, 0xE0},
+            {device_type::sio, 0xD8},
+        },
+    };
+    return p;
+}
+
+} // namespace platform::partner
@@ -0,0 +1,47 @@
+// platform.cpp
+// Registry of the compiled-in machine profiles.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <platform/platform.h>
+
+#include <array>
+
+namespace platform {
+
+std::string_view device_name(device_type type)
+{
+    switch (type)
+    {
+    case device_type::sio: return "sio";
+    case device_type::ctc: return "ctc";
+    }
+    return "unknown";
+}
+
+std::optional<device_type> find_device_type(std::string_view name)
+{
+    for (auto type : {device_type::sio, device_type::ctc})
+        if (device_name(type) == name)
+            return type;
+    return std::nullopt;
+}
+
+std::span<const profile *const> profiles()
+{
+    static const std::array<const profile *, 2> all = {
+        &none::machine(),
+        &partner::machine(),
+    };
+    return all;
+}
+
+const profile *find_profile(std::string_view name)
+{
+    for (const profile *p : profiles())
+        if (p->name == name)
+            return p;
+    return nullptr;
+}
+
+} // namespace platform
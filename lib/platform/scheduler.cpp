@@ -0,0 +1,113 @@
+// scheduler.cpp
+// T-state clock and event scheduler for device timing.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <platform/scheduler.h>
+
+#include <algorithm>
+
+namespace platform {
+
+namespace {
+
+struct later {
+    template <typename E>
+    bool operator()(const E &a, const E &b) const { return a.at > b.at; }
+};
+
+} // namespace
+
+void scheduler::run_due()
+{
+    while (!heap_.empty() && heap_.front().at <= now_)
+    {
+        std::pop_heap(heap_.begin(), heap_.end(), later{});
+        entry e = heap_.back();
+        heap_.pop_back();
+
+        auto &s = slots_[e.slot];
+        if (!s.owner || s.generation != e.generation)
+            continue;
+        // Bump the generation so the entry is spent even if the callback
+        // re-arms the timer.
+        ++s.generation;
+        s.owner->armed_ = false;
+        --armed_;
+        s.owner->fire_(e.at);
+    }
+    next_ = heap_.empty() ? std::numeric_limits<uint64_t>::max() : heap_.front().at;
+}
+
+uint32_t scheduler::add_timer(timer *owner)
+{
+    if (!free_slots_.empty())
+    {
+        uint32_t index = free_slots_.back();
+        free_slots_.pop_back();
+        slots_[index].owner = owner;
+        return index;
+    }
+    slots_.push_back({owner, 0});
+    return static_cast<uint32_t>(slots_.size() - 1);
+}
+
+void scheduler::remove_timer(uint32_t index)
+{
+    slots_[index].owner = nullptr;
+    ++slots_[index].generation;
+    free_slots_.push_back(index);
+}
+
+void scheduler::push(uint64_t at, uint32_t index)
+{
+    // Cancelled and re-armed timers leave stale entries behind; drop them
+    // once they outnumber the live ones.
+    if (heap_.size() > 2 * armed_ + 16)
+        compact();
+
+    heap_.push_back({at, index, slots_[index].generation});
+    std::push_heap(heap_.begin(), heap_.end(), later{});
+    next_ = heap_.front().at;
+}
+
+void scheduler::compact()
+{
+    std::erase_if(heap_, [this](const entry &e)
+    {
+        const auto &s = slots_[e.slot];
+        return !s.owner || s.generation != e.generation;
+    });
+    std::make_heap(heap_.begin(), heap_.end(), later{});
+    next_ = heap_.empty() ? std::numeric_limits<uint64_t>::max() : heap_.front().at;
+}
+
+scheduler::timer::timer(scheduler &clock, std::function<void(uint64_t)> fire)
+    : clock_(clock), slot_(clock.add_timer(this)), fire_(std::move(fire))
+{
+}
+
+scheduler::timer::~timer()
+{
+    cancel();
+    clock_.remove_timer(slot_);
+}
+
+void scheduler::timer::arm(uint64_t at)
+{
+    cancel();
+    armed_ = true;
+    ++clock_.armed_;
+    clock_.push(at, slot_);
+}
+
+void scheduler::timer::cancel()
+{
+    if (!armed_)
+        return;
+    armed_ = false;
+    --clock_.armed_;
+    ++clock_.slots_[slot_].generation;
+}
+
+} // namespace platform
@@ -0,0 +1,98 @@
+// sio.cpp
+// Console character device modelled on one channel of a Z80 SIO.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <platform/sio.h>
+
+namespace platform {
+
+namespace {
+
+constexpr uint8_t rr0_rx_available = 0x01;
+constexpr uint8_t rr0_tx_empty = 0x04;
+constexpr uint8_t rr1_all_sent = 0x01;
+
+} // namespace
+
+sio::sio(std::function<void(uint8_t)> output)
+    : output_(std::move(output))
+{
+}
+
+uint8_t sio::read(uint8_t offset)
+{
+    if (offset == 0)
+    {
+        if (input_.empty())
+            return 0;
+        uint8_t c = input_.front();
+        input_.pop_front();
+        return c;
+    }
+
+    uint8_t reg = pointer_;
+    pointer_ = 0;
+    switch (reg)
+    {
+    case 0:
+        return static_cast<uint8_t>(rr0_tx_empty |
+                                    (input_.empty() ? 0 : rr0_rx_available));
+    case 1:
+        return rr1_all_sent;
+    case 2:
+        return wr_[2];
+    default:
+        return 0;
+    }
+}
+
+void sio::write(uint8_t offset, uint8_t value)
+{
+    if (offset == 0)
+    {
+        if (output_)
+            output_(value);
+        return;
+    }
+
+    if (pointer_ != 0)
+    {
+        wr_[pointer_] = value;
+        pointer_ = 0;
+        return;
+    }
+    wr_[0] = value;
+    pointer_ = value & 0x07;
+    // Channel reset (command 3) clears the register file.
+    if (((value >> 3) & 0x07) == 3)
+    {
+        wr_.fill(0);
+        pointer_ = 0;
+    }
+}
+
+void sio::save(state_writer &out) const
+{
+    out.put(wr_);
+    out.put(pointer_);
+    out.put(static_cast<uint32_t>(input_.size()));
+    for (uint8_t c : input_)
+        out.put(c);
+}
+
+void sio::load(state_reader &in)
+{
+    wr_ = in.get<std::array<uint8_t, 8>>();
+    pointer_ = in.get<uint8_t>();
+    input_.clear();
+    for (auto n = in.get<uint32_t>(); n && in.ok(); --n)
+        input_.push_back(in.get<uint8_t>());
+}
+
+void sio::receive(std::string_view text)
+{
+    input_.insert(input_.end(), text.begin(), text.end());
+}
+
+} // namespace platform
@@ -16,27 +16,53 @@
 
 namespace sdcc {
 
-bool cdb_parser::do_parse(const std::string& path) {
-    auto lines = util::read_lines(path);
-    if (!lines) {
-        return false;
+namespace {
+
+// Split off the next non-empty, trimmed field up to `delim`, as
+// util::split would list it; empty once the text runs out. Scans in
+// place, so walking a record's fields allocates nothing.
+std::string_view next_field(std::string_view& text, char delim) {
+    while (!text.empty()) {
+        size_t end = text.find(delim);
+        auto field = util::trim(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        if (!field.empty()) {
+            return field;
+        }
     }
+    return {};
+}
+
+} // namespace
 
+bool cdb_parser::do_parse(const std::string& path) {
+    // Stream the file and parse records straight out of the read buffer.
     data_.clear();
-    current_module_.clear();
+    current_module_ = npos;
+    modules_.clear();
+    functions_.clear();
+    global_functions_.clear();
 
-    for (const auto& line : *lines) {
+    return util::for_each_line(path, [this](std::string_view line) {
         auto trimmed = util::trim(line);
-        if (trimmed.empty()) {
-            continue;
+        if (!trimmed.empty()) {
+            parse_line(trimmed);
         }
-        parse_line(trimmed);
-    }
-    return true;
+    });
+}
+
+cdbg_info_module* cdb_parser::find_module(std::string_view name) {
+    auto it = modules_.find(name);
+    return it != modules_.end() ? &data_[it->second] : nullptr;
+}
+
+cdbg_info_function* cdb_parser::find_function(size_t module, std::string_view name) {
+    auto it = functions_[module].find(name);
+    return it != functions_[module].end() ? &data_[module].functions[it->second] : nullptr;
 }
 
 void cdb_parser::parse_line(std::string_view line) {
-    if (line.empty() || line[1] != ':') {
+    if (line.size() < 2 || line[1] != ':') {
         return;
     }
 
@@ -55,15 +81,19 @@ void cdb_parser::parse_line(std::string_view line) {
 
 void cdb_parser::parse_module(std::string_view content) {
     cdbg_info_module module;
-    module.name = std::string(content);
+    module.name = content;
     module.file = module.name + ".c"; // Default file path
-    current_module_ = module.name;
-    data_.push_back(module);
+
+    // A repeated M: record continues the first module of that name.
+    auto [it, inserted] = modules_.try_emplace(module.name, data_.size());
+    current_module_ = it->second;
+    data_.push_back(std::move(module));
+    functions_.emplace_back();
 }
 
 void cdb_parser::parse_function(std::string_view content) {
     // Example: F:G$clock_init$0_0$0({2}DF,SV:S),Z,0,0,0,0,0
-    if (current_module_.empty()) return; // No module context
+    if (current_module_ == npos) return; // No module context
 
     cdbg_info_function func;
     func.scope = (content[0] == 'G') ? "global" : "local";
@@ -75,20 +105,39 @@ void cdb_parser::parse_function(std::string_view content) {
     size_t next_dollar = content.find('$', dollar_pos + 1);
     if (next_dollar == std::string_view::npos) return;
 
-    func.name = std::string(content.substr(dollar_pos + 1, next_dollar - dollar_pos - 1));
+    std::string_view name = content.substr(dollar_pos + 1, next_dollar - dollar_pos - 1);
     // Remove module prefix if present (e.g., "clock." in "clock.clock_init")
-    size_t dot_pos = func.name.find('.');
-    if (dot_pos != std::string::npos) {
-        func.name = func.name.substr(dot_pos + 1);
+    size_t dot_pos = name.find('.');
+    if (dot_pos != std::string_view::npos) {
+        name.remove_prefix(dot_pos + 1);
+    }
+    func.name = name;
+
+    // Attributes follow the type: address space, on stack, stack (frame
+    // size), interrupt, interrupt number, register bank.
+    size_t paren_pos = content.find(')');
+    if (paren_pos != std::string_view::npos && paren_pos + 1 < content.size()) {
+        // Attributes are optional, ignore parse errors
+        std::string_view attrs = content.substr(paren_pos + 2);
+        next_field(attrs, ',');
+        next_field(attrs, ',');
+        if (auto stack = next_field(attrs, ','); !stack.empty()) {
+            util::to_number(stack, func.stack);
+        }
+        int interrupt = 0;
+        if (auto flag = next_field(attrs, ',');
+            !flag.empty() && util::to_number(flag, interrupt)) {
+            func.interrupt = interrupt != 0;
+        }
     }
 
     // Add to current module
-    for (auto& module : data_) {
-        if (module.name == current_module_) {
-            module.functions.push_back(func);
-            break;
-        }
+    auto& functions = data_[current_module_].functions;
+    functions_[current_module_].try_emplace(func.name, functions.size());
+    if (func.scope == "global") {
+        global_functions_.try_emplace(func.name, current_module_, functions.size());
     }
+    functions.push_back(std::move(func));
 }
 
 void cdb_parser::parse_symbol(std::string_view content) {
@@ -96,7 +145,7 @@ void cdb_parser::parse_symbol(std::string_view content) {
     // S:Lclock.clock_loop$hour$1_1$41({2}SI:S),B,1,-2
     // S:G$SECOND$0_0$0({1}SC:U),I,0,0
     // S:Fclock$clk$0_0$0({97}STclock_s:S),E,0,0
-    if (current_module_.empty()) return;
+    if (current_module_ == npos) return;
 
     cdbg_info_symbol symbol;
     char scope_char = content[0];
@@ -112,18 +161,19 @@ void cdb_parser::parse_symbol(std::string_view content) {
     // Symbol name is between first and second '$'
     size_t name_end = content.find('$', dollar_pos + 1);
     if (name_end == std::string_view::npos) return;
-    std::string sym_name(content.substr(dollar_pos + 1, name_end - dollar_pos - 1));
+    std::string_view sym_name = content.substr(dollar_pos + 1, name_end - dollar_pos - 1);
 
     // Extract type info from parentheses, e.g. "{2}SI:S"
     size_t paren_pos = content.find('(');
     if (paren_pos != std::string_view::npos) {
         size_t end_paren = content.find(')', paren_pos);
         if (end_paren != std::string_view::npos) {
-            symbol.type_info = std::string(content.substr(paren_pos + 1, end_paren - paren_pos - 1));
+            symbol.type_info = content.substr(paren_pos + 1, end_paren - paren_pos - 1);
         }
     }
 
     symbol.name = sym_name;
+    auto& module = data_[current_module_];
 
     if (scope_char == 'L') {
         // Local symbol: scope_prefix = "clock.clock_loop" (module.function)
@@ -131,43 +181,27 @@ void cdb_parser::parse_symbol(std::string_view content) {
         size_t dot_pos = scope_prefix.find('.');
         if (dot_pos == std::string_view::npos) return;
 
-        std::string module_name(scope_prefix.substr(0, dot_pos));
-        std::string function_name(scope_prefix.substr(dot_pos + 1));
-
-        for (auto& module : data_) {
-            if (module.name == current_module_ && module_name == current_module_) {
-                for (auto& func : module.functions) {
-                    if (func.name == function_name) {
-                        func.local_symbols.push_back(symbol);
-                        return;
-                    }
-                }
-            }
+        std::string_view module_name = scope_prefix.substr(0, dot_pos);
+        std::string_view function_name = scope_prefix.substr(dot_pos + 1);
+        if (module_name != module.name) return;
+
+        if (auto* func = find_function(current_module_, function_name)) {
+            func->local_symbols.push_back(std::move(symbol));
         }
     } else if (scope_char == 'G') {
         // Global symbol: name is between 1st and 2nd '$'
         symbol.scope = "global";
-        for (auto& module : data_) {
-            if (module.name == current_module_) {
-                module.global_symbols.push_back(symbol);
-                break;
-            }
-        }
+        module.global_symbols.push_back(std::move(symbol));
     } else {
         // File-scope (F) or struct-scope (S) — add as module-level symbol
         symbol.scope = (scope_char == 'F') ? "local" : "struct";
-        for (auto& module : data_) {
-            if (module.name == current_module_) {
-                module.global_symbols.push_back(symbol);
-                break;
-            }
-        }
+        module.global_symbols.push_back(std::move(symbol));
     }
 }
 
 void cdb_parser::parse_type(std::string_view content) {
     // Example: T:Fclock$dim_s[({0}S:S$w$0_0$0({2}SI:S),Z,0,0)({2}S:S$h$0_0$0({2}SI:S),Z,0,0)]
-    if (current_module_.empty()) return;
+    if (current_module_ == npos) return;
 
     cdbg_info_type type;
     type.scope = (content[0] == 'G') ? "global" : "local";
@@ -179,28 +213,22 @@ void cdb_parser::parse_type(std::string_view content) {
     size_t bracket_pos = content.find('[');
     if (bracket_pos == std::string_view::npos) return;
 
-    std::string full_name = std::string(content.substr(dollar_pos + 1, bracket_pos - dollar_pos - 1));
+    std::string_view full_name = content.substr(dollar_pos + 1, bracket_pos - dollar_pos - 1);
     // Extract type info
     size_t end_bracket = content.find_last_of(']');
     if (end_bracket != std::string_view::npos) {
-        type.type_info = std::string(content.substr(bracket_pos, end_bracket - bracket_pos + 1));
+        type.type_info = content.substr(bracket_pos, end_bracket - bracket_pos + 1);
     }
 
     // Remove module prefix
     size_t dot_pos = full_name.find('.');
-    if (dot_pos != std::string::npos) {
-        type.name = full_name.substr(dot_pos + 1);
-    } else {
-        type.name = full_name;
+    if (dot_pos != std::string_view::npos) {
+        full_name.remove_prefix(dot_pos + 1);
     }
+    type.name = full_name;
 
     // Add to current module
-    for (auto& module : data_) {
-        if (module.name == current_module_) {
-            module.types.push_back(type);
-            break;
-        }
-    }
+    data_[current_module_].types.push_back(std::move(type));
 }
 
 void cdb_parser::parse_line_info(std::string_view content) {
@@ -208,60 +236,110 @@ void cdb_parser::parse_line_info(std::string_view content) {
     // L:C$clock.c$18$0_0$36:116    (C source line)
     // L:A$clock/path/clock$76:116   (Assembly line)
     // L:G$SECOND$0_0$0:A2           (Global symbol address)
-    if (current_module_.empty()) return;
+    if (current_module_ == npos || content.empty()) return;
 
     char type = content[0];
 
-    // Only handle C source lines for now
+    // Function entry and end addresses
+    if (type == 'G' || type == 'F' || type == 'X') {
+        parse_function_address(content);
+        return;
+    }
+
+    // Only handle C source lines otherwise
     // Format: C$file$line$level$block:address
     if (type != 'C') return;
 
-    auto parts = util::split(content, '$');
-    // parts: ["C", "clock.c", "18", "0_0", "36:116"]
-    if (parts.size() < 4) return;
+    // Fields: "C", "clock.c", "18", "0_0", "36:116"
+    size_t file_pos = content.find('$');
+    if (file_pos == std::string_view::npos) return;
+    size_t line_pos = content.find('$', file_pos + 1);
+    if (line_pos == std::string_view::npos) return;
+    size_t level_pos = content.find('$', line_pos + 1);
+    if (level_pos == std::string_view::npos) return;
+
+    std::string_view file = content.substr(file_pos + 1, line_pos - file_pos - 1);
+    std::string_view line_number = content.substr(line_pos + 1, level_pos - line_pos - 1);
+
+    // Match module by file name rather than current_module_, because
+    // L: records can appear after a different M: record in the CDB file.
+    // e.g. "clock.c" -> module "clock"
+    size_t dot_pos = file.rfind('.');
+    auto* module = find_module(dot_pos != std::string_view::npos
+        ? file.substr(0, dot_pos) : std::string_view{});
+    if (!module) return;
 
     cdbg_info_line line;
     line.scope = "local";
-    line.file = std::string(parts[1]);
-    std::replace(line.file.begin(), line.file.end(), '\\', '/');
 
-    // Line number is parts[2], decimal
-    try {
-        line.line = std::stoi(std::string(parts[2]));
-    } catch (...) {
-        return;
-    }
+    // Line number is decimal
+    if (!util::to_number(line_number, line.line)) return;
 
-    // Address is after the last ':' in the last part
-    std::string_view last_part = parts.back();
+    // Address is after the ':' in the last field; it is optional, ignore
+    // parse errors
+    std::string_view last_part = content.substr(content.rfind('$') + 1);
     size_t colon_pos = last_part.find(':');
     if (colon_pos != std::string_view::npos) {
-        try {
-            line.address = static_cast<uint16_t>(
-                std::stoul(std::string(last_part.substr(colon_pos + 1)), nullptr, 16));
-        } catch (...) {
-            // Address is optional, ignore parse errors
-        }
+        util::to_number(last_part.substr(colon_pos + 1), line.address, 16);
     }
 
-    // Match module by file name rather than current_module_, because
-    // L: records can appear after a different M: record in the CDB file.
-    // e.g. "clock.c" -> module "clock"
-    std::string module_name;
-    size_t dot_pos = line.file.rfind('.');
-    if (dot_pos != std::string::npos) {
-        module_name = line.file.substr(0, dot_pos);
+    line.file = file;
+    std::replace(line.file.begin(), line.file.end(), '\\', '/');
+    if (module->file.size() == module->name.size() + 2 &&
+        module->file.ends_with(".c") && module->file.starts_with(module->name)) {
+        module->file = line.file;
+    }
+    module->lines.push_back(std::move(line));
+}
+
+void cdb_parser::parse_function_address(std::string_view content) {
+    // Examples:
+    // L:G$clock_loop$0$0:183        (Global function entry)
+    // L:XG$clock_loop$0$0:3B2       (Global function end)
+    // L:Fscreen$_rotate$0$0:567     (Static function entry)
+    // L:XFscreen$_rotate$0$0:717    (Static function end)
+    // G records also give addresses of global variables; those names
+    // don't match a function and are skipped.
+    bool end = content[0] == 'X';
+    if (end) {
+        content.remove_prefix(1);
     }
+    if (content.empty() || (content[0] != 'G' && content[0] != 'F')) return;
+    bool global = content[0] == 'G';
+
+    size_t dollar_pos = content.find('$');
+    if (dollar_pos == std::string_view::npos) return;
+    size_t name_end = content.find('$', dollar_pos + 1);
+    if (name_end == std::string_view::npos) return;
+    size_t colon_pos = content.rfind(':');
+    if (colon_pos == std::string_view::npos) return;
 
-    for (auto& module : data_) {
-        if (module.name == module_name) {
-            if (module.file == module.name + ".c") {
-                module.file = line.file;
-            }
-            module.lines.push_back(line);
-            return;
+    std::string_view module_name = content.substr(1, dollar_pos - 1);
+    std::string_view name = content.substr(dollar_pos + 1, name_end - dollar_pos - 1);
+
+    uint32_t address;
+    if (!util::to_number(content.substr(colon_pos + 1), address, 16)) return;
+
+    cdbg_info_function* func = nullptr;
+    if (global) {
+        auto it = global_functions_.find(name);
+        if (it != global_functions_.end()) {
+            func = &data_[it->second.first].functions[it->second.second];
+        }
+    } else if (auto module = modules_.find(module_name); module != modules_.end()) {
+        func = find_function(module->second, name);
+        if (func && func->scope == "global") {
+            func = nullptr;
         }
     }
+    if (!func) return;
+
+    if (end) {
+        func->end = address;
+    } else {
+        func->start = address;
+        func->has_range = true;
+    }
 }
 
 } // namespace sdcc
\ No newline at end of file
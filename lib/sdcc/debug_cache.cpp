@@ -0,0 +1,350 @@
+// debug_cache.cpp
+// Implementation of the persistent binary debug information cache.
+//
+// Layout (native byte order, the cache is local to the machine):
+//   magic "MUDAPDBC", format version, byte order marker,
+//   CDB file stamp, MAP file stamp,
+//   modules (when the CDB was present), segments and symbols (MAP).
+// Strings are a 32-bit length followed by the bytes, vectors a 32-bit
+// count followed by the elements.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <type_traits>
+
+#include <sdcc/debug_cache.h>
+
+namespace sdcc {
+
+namespace {
+
+constexpr char magic[8] = {'M', 'U', 'D', 'A', 'P', 'D', 'B', 'C'};
+constexpr uint32_t format_version = 2;
+constexpr uint32_t byte_order = 0x01020304;
+
+std::optional<std::string> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    std::string content(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(content.data(), static_cast<std::streamsize>(content.size()))) {
+        return std::nullopt;
+    }
+    return content;
+}
+
+uint64_t hash_file(const std::string& path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    std::ifstream file(path, std::ios::binary);
+    char buffer[64 * 1024];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        for (std::streamsize i = 0; i < file.gcount(); ++i) {
+            hash ^= static_cast<uint8_t>(buffer[i]);
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+// Size and modification time only; the hash is computed on demand.
+file_stamp stat_file(const std::string& path) {
+    namespace fs = std::filesystem;
+    file_stamp stamp;
+    std::error_code ec;
+    if (path.empty() || !fs::is_regular_file(path, ec)) {
+        return stamp;
+    }
+    auto size = fs::file_size(path, ec);
+    if (ec) return stamp;
+    auto mtime = fs::last_write_time(path, ec);
+    if (ec) return stamp;
+    stamp.exists = true;
+    stamp.size = size;
+    stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return stamp;
+}
+
+// Sets touched when only the modification time differs and the content
+// hash vouched for the file; the caller then records the new time.
+bool matches(file_stamp& recorded, const std::string& path, bool& touched) {
+    auto current = stat_file(path);
+    if (recorded.exists != current.exists) return false;
+    if (!current.exists) return true;
+    if (recorded.size != current.size) return false;
+    if (recorded.mtime == current.mtime) return true;
+    // Same size but touched (rebuilt, checked out): trust the content.
+    if (recorded.hash != hash_file(path)) return false;
+    recorded.mtime = current.mtime;
+    touched = true;
+    return true;
+}
+
+// Writes to a temporary file and renames it over the cache, so a
+// concurrent launch never reads a half-written cache.
+bool replace_file(const std::string& path, std::string_view content) {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(content.data(), static_cast<std::streamsize>(content.size()))) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+class writer {
+public:
+    writer() : out_(magic, sizeof(magic)) {}
+
+    template<typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void put(const std::string& s) {
+        put(static_cast<uint32_t>(s.size()));
+        out_.append(s);
+    }
+    template<typename T, typename F>
+    void put(const std::vector<T>& items, F&& put_item) {
+        put(static_cast<uint32_t>(items.size()));
+        for (const auto& item : items) {
+            put_item(item);
+        }
+    }
+    void put(const file_stamp& stamp) {
+        put(static_cast<uint8_t>(stamp.exists));
+        put(stamp.size);
+        put(stamp.mtime);
+        put(stamp.hash);
+    }
+    const std::string& str() const { return out_; }
+
+private:
+    std::string out_;
+};
+
+// Reads from the cache buffer; any overrun marks the reader failed and
+// yields zero values from then on.
+class reader {
+public:
+    explicit reader(std::string_view in) : in_(in) {}
+
+    template<typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (in_.size() < sizeof(T)) {
+            failed_ = true;
+            return value;
+        }
+        std::memcpy(&value, in_.data(), sizeof(T));
+        in_.remove_prefix(sizeof(T));
+        return value;
+    }
+    std::string get_string() {
+        auto size = get<uint32_t>();
+        if (in_.size() < size) {
+            failed_ = true;
+            return {};
+        }
+        std::string s(in_.substr(0, size));
+        in_.remove_prefix(size);
+        return s;
+    }
+    template<typename T, typename F>
+    void get_vector(std::vector<T>& items, F&& get_item) {
+        auto count = get<uint32_t>();
+        // Every element takes at least one byte, so a larger count can
+        // only come from a damaged file.
+        if (count > in_.size()) {
+            failed_ = true;
+            return;
+        }
+        items.resize(count);
+        for (auto& item : items) {
+            get_item(item);
+        }
+    }
+    file_stamp get_stamp() {
+        file_stamp stamp;
+        stamp.exists = get<uint8_t>() != 0;
+        stamp.size = get<uint64_t>();
+        stamp.mtime = get<int64_t>();
+        stamp.hash = get<uint64_t>();
+        return stamp;
+    }
+    bool failed() const { return failed_; }
+    bool done() const { return in_.empty(); }
+
+private:
+    std::string_view in_;
+    bool failed_ = false;
+};
+
+void put_symbol(writer& w, const cdbg_info_symbol& s) {
+    w.put(s.name);
+    w.put(s.scope);
+    w.put(s.type_info);
+}
+
+void get_symbol(reader& r, cdbg_info_symbol& s) {
+    s.name = r.get_string();
+    s.scope = r.get_string();
+    s.type_info = r.get_string();
+}
+
+void put_module(writer& w, const cdbg_info_module& m) {
+    w.put(m.name);
+    w.put(m.file);
+    w.put(m.functions, [&](const cdbg_info_function& f) {
+        w.put(f.name);
+        w.put(f.scope);
+        w.put(f.local_symbols, [&](const cdbg_info_symbol& s) { put_symbol(w, s); });
+        w.put(static_cast<int32_t>(f.stack));
+        w.put(static_cast<uint8_t>(f.interrupt));
+        w.put(static_cast<uint8_t>(f.has_range));
+        w.put(f.start);
+        w.put(f.end);
+    });
+    w.put(m.global_symbols, [&](const cdbg_info_symbol& s) { put_symbol(w, s); });
+    w.put(m.types, [&](const cdbg_info_type& t) {
+        w.put(t.name);
+        w.put(t.scope);
+        w.put(t.type_info);
+    });
+    w.put(m.lines, [&](const cdbg_info_line& l) {
+        w.put(l.file);
+        w.put(static_cast<int32_t>(l.line));
+        w.put(l.address);
+        w.put(l.scope);
+    });
+}
+
+void get_module(reader& r, cdbg_info_module& m) {
+    m.name = r.get_string();
+    m.file = r.get_string();
+    r.get_vector(m.functions, [&](cdbg_info_function& f) {
+        f.name = r.get_string();
+        f.scope = r.get_string();
+        r.get_vector(f.local_symbols, [&](cdbg_info_symbol& s) { get_symbol(r, s); });
+        f.stack = r.get<int32_t>();
+        f.interrupt = r.get<uint8_t>() != 0;
+        f.has_range = r.get<uint8_t>() != 0;
+        f.start = r.get<uint32_t>();
+        f.end = r.get<uint32_t>();
+    });
+    r.get_vector(m.global_symbols, [&](cdbg_info_symbol& s) { get_symbol(r, s); });
+    r.get_vector(m.types, [&](cdbg_info_type& t) {
+        t.name = r.get_string();
+        t.scope = r.get_string();
+        t.type_info = r.get_string();
+    });
+    r.get_vector(m.lines, [&](cdbg_info_line& l) {
+        l.file = r.get_string();
+        l.line = r.get<int32_t>();
+        l.address = r.get<uint32_t>();
+        l.scope = r.get_string();
+    });
+}
+
+} // namespace
+
+std::optional<debug_info> debug_cache::load(const std::string& cdb_path,
+                                            const std::string& map_path) const {
+    auto content = read_file(path_);
+    if (!content || content->size() < sizeof(magic) ||
+        std::memcmp(content->data(), magic, sizeof(magic)) != 0) {
+        return std::nullopt;
+    }
+
+    reader r(std::string_view(*content).substr(sizeof(magic)));
+    if (r.get<uint32_t>() != format_version || r.get<uint32_t>() != byte_order) {
+        return std::nullopt;
+    }
+    auto cdb_stamp = r.get_stamp();
+    auto map_stamp = r.get_stamp();
+    bool touched = false;
+    if (r.failed() || !matches(cdb_stamp, cdb_path, touched) ||
+        !matches(map_stamp, map_path, touched)) {
+        return std::nullopt;
+    }
+
+    debug_info info;
+    info.has_cdb = r.get<uint8_t>() != 0;
+    r.get_vector(info.modules, [&](cdbg_info_module& m) { get_module(r, m); });
+    info.has_map = r.get<uint8_t>() != 0;
+    r.get_vector(info.map.segments, [&](segment& s) {
+        s.name = r.get_string();
+        s.address = r.get<uint32_t>();
+        s.size = r.get<uint32_t>();
+        s.attributes = r.get_string();
+    });
+    r.get_vector(info.map.symbols, [&](symbol& s) {
+        s.name = r.get_string();
+        s.address = r.get<uint32_t>();
+        s.area = r.get_string();
+        s.bank = r.get<int32_t>();
+    });
+    if (r.failed() || !r.done()) {
+        return std::nullopt;
+    }
+
+    // Record the new modification times, so the next launch matches on
+    // them again instead of hashing the sources every time. Best effort:
+    // failing to write only costs the hash next time.
+    if (touched) {
+        writer w;
+        w.put(format_version);
+        w.put(byte_order);
+        w.put(cdb_stamp);
+        w.put(map_stamp);
+        content->replace(0, w.str().size(), w.str());
+        replace_file(path_, *content);
+    }
+    return info;
+}
+
+bool debug_cache::save(const debug_info& info, const std::string& cdb_path,
+                       const std::string& map_path) const {
+    auto cdb_stamp = stat_file(cdb_path);
+    if (cdb_stamp.exists) cdb_stamp.hash = hash_file(cdb_path);
+    auto map_stamp = stat_file(map_path);
+    if (map_stamp.exists) map_stamp.hash = hash_file(map_path);
+
+    writer w;
+    w.put(format_version);
+    w.put(byte_order);
+    w.put(cdb_stamp);
+    w.put(map_stamp);
+    w.put(static_cast<uint8_t>(info.has_cdb));
+    w.put(info.modules, [&](const cdbg_info_module& m) { put_module(w, m); });
+    w.put(static_cast<uint8_t>(info.has_map));
+    w.put(info.map.segments, [&](const segment& s) {
+        w.put(s.name);
+        w.put(s.address);
+        w.put(s.size);
+        w.put(s.attributes);
+    });
+    w.put(info.map.symbols, [&](const symbol& s) {
+        w.put(s.name);
+        w.put(s.address);
+        w.put(s.area);
+        w.put(static_cast<int32_t>(s.bank));
+    });
+
+    return replace_file(path_, w.str());
+}
+
+} // namespace sdcc
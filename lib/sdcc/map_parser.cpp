@@ -1,76 +1,182 @@
 // map_parser.cpp
 // Implementation of MAP parser for SDCC/ASxxxx linker output.
 //
+// Lines are scanned by hand rather than with std::regex; the accepted
+// syntax is exactly that of the two patterns noted below.
+//
 // Copyright 2025 Tomaz Stih. All rights reserved.
 // MIT License.
-#include <regex>
-
 #include <sdcc/map_parser.h>
 #include <sdcc/util.h>
 
 namespace sdcc {
 
-std::optional<map_info> map_parser::parse(const std::string& path)
+namespace {
+
+bool is_space(char c)
 {
-    auto lines = util::read_lines(path);
-    if (!lines)
-        return std::nullopt;
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+bool is_hex(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+bool is_name(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+           (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '$';
+}
+
+// Split off the next whitespace separated token, empty at end of line.
+std::string_view next_token(std::string_view& line)
+{
+    size_t start = 0;
+    while (start < line.size() && is_space(line[start]))
+        ++start;
+    size_t end = start;
+    while (end < line.size() && !is_space(line[end]))
+        ++end;
+    auto token = line.substr(start, end - start);
+    line.remove_prefix(end);
+    return token;
+}
+
+// Match (0x)?[0-9A-Fa-f]{4,8} at the start of text. Returns the matched
+// length (0 for no match) and stores the number in value.
+size_t match_hex(std::string_view text, uint32_t& value)
+{
+    size_t prefix = text.size() > 1 && text[0] == '0' &&
+                    (text[1] == 'x' || text[1] == 'X') ? 2 : 0;
+    size_t end = prefix;
+    while (end < text.size() && end - prefix < 8 && is_hex(text[end]))
+        ++end;
+    if (end - prefix < 4)
+        return 0;
+    util::to_number(text.substr(prefix, end - prefix), value, 16);
+    return end;
+}
+
+// A whole token that is a 4-8 digit hex number.
+bool hex_token(std::string_view token, uint32_t& value)
+{
+    return !token.empty() && match_hex(token, value) == token.size();
+}
 
+// Example:
+// _CODE 00000100 000025FF = 9727. bytes (REL,CON)
+// ^\s*([A-Za-z0-9_.\$]+)\s+((?:0[xX])?[0-9A-Fa-f]{4,8})\s+((?:0[xX])?[0-9A-Fa-f]{4,8}).*\(([^)]*)\)\s*$
+bool parse_segment(std::string_view line, segment& s)
+{
+    auto name = next_token(line);
+    if (name.empty())
+        return false;
+    for (char c : name)
+        if (!is_name(c))
+            return false;
+
+    if (!hex_token(next_token(line), s.address))
+        return false;
+
+    // The size only has to start with hex digits; anything may follow
+    // up to the attributes.
+    size_t skip = 0;
+    while (skip < line.size() && is_space(line[skip]))
+        ++skip;
+    if (skip == 0)
+        return false;
+    line.remove_prefix(skip);
+    size_t size_len = match_hex(line, s.size);
+    if (size_len == 0)
+        return false;
+    line.remove_prefix(size_len);
+
+    while (!line.empty() && is_space(line.back()))
+        line.remove_suffix(1);
+    if (line.empty() || line.back() != ')')
+        return false;
+    line.remove_suffix(1);
+    size_t open = line.rfind('(');
+    if (open == std::string_view::npos ||
+        line.find(')', open) != std::string_view::npos)
+        return false;
+
+    s.name = name;
+    s.attributes = line.substr(open + 1);
+    return true;
+}
+
+// Example:
+// 00000116  C$clock.c$18$0_0$36                clock
+// ^\s*((?:0[xX])?[0-9A-Fa-f]{4,8})\s+([^\s]+)(?:\s+([^\s]+))?\s*$
+bool parse_symbol(std::string_view line, symbol& s)
+{
+    if (!hex_token(next_token(line), s.address))
+        return false;
+    auto name = next_token(line);
+    auto area = next_token(line);
+    if (name.empty() || !next_token(line).empty())
+        return false;
+
+    // Skip table headings.
+    if (name == "Global")
+        return false;
+
+    s.name = name;
+    s.area = area;
+    s.bank = 0;
+    return true;
+}
+
+} // namespace
+
+std::optional<map_info> map_parser::parse(const std::string& path)
+{
     data_ = {};
 
-    // Example:
-    // _CODE 00000100 000025FF = 9727. bytes (REL,CON)
-    const std::regex segment_re(
-        R"(^\s*([A-Za-z0-9_.\$]+)\s+((?:0[xX])?[0-9A-Fa-f]{4,8})\s+((?:0[xX])?[0-9A-Fa-f]{4,8}).*\(([^)]*)\)\s*$)");
+    // Scratch records are reused across lines so a non-matching line
+    // costs no allocation.
+    segment seg;
+    symbol sym;
+    bool ok = util::for_each_line(path, [&](std::string_view raw)
+    {
+        auto line = util::trim(raw);
+        if (line.empty())
+            return;
 
-    // Example:
-    // 00000116  C$clock.c$18$0_0$36                clock
-    const std::regex symbol_re(
-        R"(^\s*((?:0[xX])?[0-9A-Fa-f]{4,8})\s+([^\s]+)(?:\s+([^\s]+))?\s*$)");
+        if (parse_segment(line, seg))
+            data_.segments.push_back(seg);
+        else if (parse_symbol(line, sym))
+            data_.symbols.push_back(sym);
+    });
+    if (!ok)
+        return std::nullopt;
 
-    for (const auto& raw : *lines)
+    // Hand the result over instead of copying it, like parser_impl.
+    return std::move(data_);
+}
+
+symbol_rank_value symbol_rank(std::string_view name)
+{
+    // F<module>$<fn>$0$0 starts a static function, XF<module>$... ends it;
+    // global ones are G$<fn>$0$0 and XG$<fn>$0$0.
+    auto debug_name = [](std::string_view n)
     {
-        std::string line(raw);
-        auto trimmed = util::trim(line);
-        if (trimmed.empty())
-            continue;
-
-        if (auto seg = util::match(trimmed, segment_re))
-        {
-            try
-            {
-                segment s;
-                s.name = (*seg)[0];
-                s.address = static_cast<uint32_t>(std::stoul((*seg)[1], nullptr, 16));
-                s.size = static_cast<uint32_t>(std::stoul((*seg)[2], nullptr, 16));
-                s.attributes = (*seg)[3];
-                data_.segments.push_back(std::move(s));
-                continue;
-            }
-            catch (...) {}
-        }
-
-        if (auto sym = util::match(trimmed, symbol_re))
-        {
-            // Skip table headings.
-            if ((*sym)[0] == "Value" || (*sym)[1] == "Global")
-                continue;
-
-            try
-            {
-                symbol s;
-                s.address = static_cast<uint32_t>(std::stoul((*sym)[0], nullptr, 16));
-                s.name = (*sym)[1];
-                s.area = (sym->size() > 2) ? (*sym)[2] : "";
-                s.bank = 0;
-                data_.symbols.push_back(std::move(s));
-                continue;
-            }
-            catch (...) {}
-        }
-    }
-
-    return data_;
+        return n.size() > 2 && (n[0] == 'G' || n[0] == 'F') &&
+               n.find('$') != std::string_view::npos;
+    };
+    if (name.starts_with("C$") || name.starts_with("A$") ||
+        name.starts_with("l__") ||
+        (name.starts_with('X') && debug_name(name.substr(1))))
+        return rank_none;
+    if (name.size() > 1 && name[0] == '_')
+        return rank_c;
+    if (name.starts_with("s__"))
+        return rank_area;
+    if ((name.size() > 1 && name[1] == '$') || debug_name(name))
+        return rank_debug;
+    return rank_label;
 }
 
 } // namespace sdcc
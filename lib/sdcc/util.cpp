@@ -28,12 +28,17 @@ namespace sdcc::util {
     }
 
     std::string_view trim(std::string_view str) {
-        auto first = str.find_first_not_of(" \t\r\n");
-        if (first == std::string_view::npos) {
-            return {};
+        auto is_space = [](char c) {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        };
+        size_t first = 0, last = str.size();
+        while (first < last && is_space(str[first])) {
+            ++first;
         }
-        auto last = str.find_last_not_of(" \t\r\n");
-        return str.substr(first, last - first + 1);
+        while (last > first && is_space(str[last - 1])) {
+            --last;
+        }
+        return str.substr(first, last - first);
     }
 
     std::vector<std::string_view> split(std::string_view str, char delim) {
@@ -0,0 +1,149 @@
+// coverage.cpp
+// Line and function coverage from the executed-address map.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <coverage.h>
+#include <dbg.h>
+
+#include <set>
+
+namespace {
+
+std::string percent(int hit, int total)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1)
+        << (total ? 100.0 * hit / total : 0.0) << '%';
+    return oss.str();
+}
+
+} // namespace
+
+coverage_report summarize_coverage(const dbg &ctx, const exec_coverage &coverage)
+{
+    // A line is executed when any address it covers was. Addresses past
+    // the end of a line's code (data, padding) are never executed, so
+    // they don't affect the result.
+    std::map<uint16_t, coverage_report::file> files;
+    const uint32_t size = static_cast<uint32_t>(ctx.memory().store().size());
+    for (uint32_t address = 0; address < size; ++address)
+    {
+        auto loc = ctx.lookup_source(address);
+        if (!loc)
+            continue;
+        auto &f = files[loc->file_id];
+        if (f.path.empty())
+            f.path = std::string(loc->file);
+        auto &hit = f.lines[loc->line];
+        hit = hit || coverage.executed(address);
+    }
+
+    coverage_report report;
+    for (const auto &fn : ctx.functions())
+    {
+        coverage_report::function entry;
+        entry.name = fn.name;
+        entry.entered = coverage.executed(fn.start);
+
+        auto loc = ctx.lookup_source(fn.start);
+        std::set<int> lines;
+        std::set<int> hit;
+        for (uint32_t address = fn.start; address <= fn.end && address < size; ++address)
+        {
+            auto at = ctx.lookup_source(address);
+            if (!at || !loc || at->file_id != loc->file_id)
+                continue;
+            lines.insert(at->line);
+            if (coverage.executed(address))
+                hit.insert(at->line);
+        }
+        entry.lines = static_cast<int>(lines.size());
+        entry.lines_hit = static_cast<int>(hit.size());
+
+        if (loc)
+        {
+            entry.line = lines.empty() ? loc->line : *lines.begin();
+            files[loc->file_id].functions.push_back(std::move(entry));
+        }
+        else
+            report.other_functions.push_back(std::move(entry));
+    }
+
+    for (auto &[id, f] : files)
+        report.files.push_back(std::move(f));
+    std::sort(report.files.begin(), report.files.end(),
+        [](const auto &a, const auto &b) { return a.path < b.path; });
+    return report;
+}
+
+std::string coverage_lcov(const coverage_report &report, const std::string &test_name)
+{
+    std::ostringstream out;
+    for (const auto &f : report.files)
+    {
+        out << "TN:" << test_name << '\n';
+        out << "SF:" << f.path << '\n';
+
+        int entered = 0;
+        for (const auto &fn : f.functions)
+            out << "FN:" << fn.line << ',' << fn.name << '\n';
+        for (const auto &fn : f.functions)
+        {
+            out << "FNDA:" << (fn.entered ? 1 : 0) << ',' << fn.name << '\n';
+            entered += fn.entered;
+        }
+        out << "FNF:" << f.functions.size() << '\n';
+        out << "FNH:" << entered << '\n';
+
+        int hit = 0;
+        for (const auto &[line, executed] : f.lines)
+        {
+            out << "DA:" << line << ',' << (executed ? 1 : 0) << '\n';
+            hit += executed;
+        }
+        out << "LF:" << f.lines.size() << '\n';
+        out << "LH:" << hit << '\n';
+        out << "end_of_record\n";
+    }
+    return out.str();
+}
+
+std::string coverage_text(const coverage_report &report)
+{
+    int lines = 0, lines_hit = 0, functions = 0, entered = 0;
+    std::ostringstream detail;
+    auto function_line = [&](const coverage_report::function &fn)
+    {
+        ++functions;
+        entered += fn.entered;
+        detail << "  " << std::left << std::setw(32) << fn.name << std::right;
+        if (fn.lines)
+            detail << std::setw(4) << fn.lines_hit << '/' << std::setw(4) << std::left
+                   << fn.lines << std::right << " lines " << std::setw(6)
+                   << percent(fn.lines_hit, fn.lines);
+        else
+            detail << (fn.entered ? "entered" : "not entered");
+        detail << '\n';
+    };
+
+    for (const auto &f : report.files)
+    {
+        for (const auto &[line, executed] : f.lines)
+        {
+            ++lines;
+            lines_hit += executed;
+        }
+        for (const auto &fn : f.functions)
+            function_line(fn);
+    }
+    for (const auto &fn : report.other_functions)
+        function_line(fn);
+
+    std::ostringstream out;
+    out << "Coverage: " << lines_hit << '/' << lines << " lines ("
+        << percent(lines_hit, lines) << "), " << entered << '/' << functions
+        << " functions entered\n"
+        << detail.str();
+    return out.str();
+}
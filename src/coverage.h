@@ -0,0 +1,65 @@
+// coverage.h
+// Code coverage: which instructions ran, mapped back to source lines.
+//
+// While coverage is on, the CPU loop marks the physical address of every
+// instruction it executes in a byte map (a byte per address rather than a
+// bit, so marking is a plain store). That is cheap enough to leave on for
+// whole test runs. The map is turned into line and function coverage
+// through the debugger's line table, which comes from the CDB L:C$ records
+// or MAP C$ symbols, and written as an lcov tracefile.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class dbg;
+
+class exec_coverage
+{
+public:
+    // One entry per physical address; clears the map if its size changes.
+    void resize(size_t addresses)
+    {
+        if (executed_.size() != addresses)
+            executed_.assign(addresses, 0);
+    }
+    void clear() { executed_.assign(executed_.size(), 0); }
+
+    void mark(uint32_t address) { executed_[address] = 1; }
+    bool executed(uint32_t address) const
+    {
+        return address < executed_.size() && executed_[address];
+    }
+
+private:
+    std::vector<uint8_t> executed_;
+};
+
+struct coverage_report {
+    struct function {
+        std::string name;
+        int line = 0;           // First line, 0 if unknown.
+        bool entered = false;
+        int lines = 0;          // Source lines in the function's range.
+        int lines_hit = 0;
+    };
+    struct file {
+        std::string path;
+        std::map<int, bool> lines;      // Line -> executed.
+        std::vector<function> functions;
+    };
+    std::vector<file> files;            // Sorted by path.
+    // Functions without line info (assembler, libraries).
+    std::vector<function> other_functions;
+};
+
+coverage_report summarize_coverage(const dbg &ctx, const exec_coverage &coverage);
+// lcov tracefile (geninfo format), one record per source file.
+std::string coverage_lcov(const coverage_report &report, const std::string &test_name);
+// Human readable totals and one line per function.
+std::string coverage_text(const coverage_report &report);
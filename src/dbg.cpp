@@ -28,7 +28,7 @@ std::optional<source_location> map_symbol_to_source(const sdcc::symbol &sym)
         return std::nullopt;
 
     source_location loc;
-    loc.file = sym.name.substr(2, p1 - 2);
+    loc.file = std::string_view(sym.name).substr(2, p1 - 2);
     try
     {
         loc.line = std::stoi(sym.name.substr(p1 + 1, p2 - p1 - 1));
@@ -40,6 +40,19 @@ std::optional<source_location> map_symbol_to_source(const sdcc::symbol &sym)
     return loc;
 }
 
+// Record `address` for (basename of `file`, `line`), once per address.
+void add_line_address(dbg::line_address_index &index, std::string_view file,
+                      int line, uint32_t address)
+{
+    auto slash = file.find_last_of("/\\");
+    if (slash != std::string_view::npos)
+        file.remove_prefix(slash + 1);
+
+    auto &addresses = index[std::string(file)][line];
+    if (std::find(addresses.begin(), addresses.end(), address) == addresses.end())
+        addresses.push_back(address);
+}
+
 } // namespace
 
 // Forward declarations of handler factory functions (defined in handlers/).
@@ -55,12 +68,21 @@ namespace handlers {
     std::unique_ptr<dap::request_handler> make_next(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_step_in(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_step_out(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_step_back(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_reverse_continue(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_pause(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_set_breakpoints(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_set_instruction_breakpoints(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_data_breakpoint_info(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_set_data_breakpoints(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_source(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_read_memory(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_disconnect(dbg &ctx);
     std::unique_ptr<dap::request_handler> make_set_exception_breakpoints(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_profile(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_restart(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_snapshot(dbg &ctx);
+    std::unique_ptr<dap::request_handler> make_console_input(dbg &ctx);
 }
 
 void dbg::register_handlers(dap::dap &dispatcher)
@@ -76,12 +98,21 @@ void dbg::register_handlers(dap::dap &dispatcher)
     dispatcher.add_handler(handlers::make_next(*this));
     dispatcher.add_handler(handlers::make_step_in(*this));
     dispatcher.add_handler(handlers::make_step_out(*this));
+    dispatcher.add_handler(handlers::make_step_back(*this));
+    dispatcher.add_handler(handlers::make_reverse_continue(*this));
+    dispatcher.add_handler(handlers::make_pause(*this));
     dispatcher.add_handler(handlers::make_set_breakpoints(*this));
     dispatcher.add_handler(handlers::make_set_instruction_breakpoints(*this));
+    dispatcher.add_handler(handlers::make_data_breakpoint_info(*this));
+    dispatcher.add_handler(handlers::make_set_data_breakpoints(*this));
     dispatcher.add_handler(handlers::make_source(*this));
     dispatcher.add_handler(handlers::make_read_memory(*this));
     dispatcher.add_handler(handlers::make_disconnect(*this));
     dispatcher.add_handler(handlers::make_set_exception_breakpoints(*this));
+    dispatcher.add_handler(handlers::make_profile(*this));
+    dispatcher.add_handler(handlers::make_restart(*this));
+    dispatcher.add_handler(handlers::make_snapshot(*this));
+    dispatcher.add_handler(handlers::make_console_input(*this));
 }
 
 void dbg::set_event_sender(std::function<void(const std::string &)> sender)
@@ -95,133 +126,443 @@ void dbg::send_event(const std::string &event_json)
         send_event_(event_json);
 }
 
-std::string dbg::format_hex(uint16_t value, int width)
+void dbg::set_try_event_sender(std::function<bool(const std::string &)> sender)
 {
-    std::ostringstream oss;
-    oss << std::uppercase << std::setfill('0') << std::setw(width)
-        << std::hex << value;
-    return "0x" + oss.str();
+    try_send_event_ = std::move(sender);
+}
+
+bool dbg::try_send_event(const std::string &event_json)
+{
+    return try_send_event_ ? try_send_event_(event_json) : false;
+}
+
+void dbg::send_stopped_event(const std::string &reason,
+                             const std::string &description)
+{
+    nlohmann::json j;
+    j["seq"] = next_event_seq();
+    j["type"] = "event";
+    j["event"] = "stopped";
+    j["body"] = {
+        {"reason", reason},
+        {"threadId", 1},
+        {"allThreadsStopped", true}};
+    if (!description.empty())
+        j["body"]["description"] = description;
+    send_event(j.dump());
+}
+
+bool dbg::attach_device(uint8_t first, unsigned count,
+                        std::unique_ptr<platform::io_device> device)
+{
+    if (!io_.attach(first, count, *device))
+        return false;
+    devices_.push_back(std::move(device));
+    return true;
+}
+
+void dbg::clear_devices()
+{
+    io_.detach_all();
+    console_ = nullptr;
+    devices_.clear();
+    interrupts_.reset();
+}
+
+// Output event with the buffered console text. The program may write any
+// bytes; invalid UTF-8 is replaced rather than failing the dump.
+std::string dbg::console_event()
+{
+    nlohmann::json j;
+    j["seq"] = next_event_seq();
+    j["type"] = "event";
+    j["event"] = "output";
+    j["body"] = {{"category", "stdout"}, {"output", console_buffer_}};
+    return j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
 }
 
-std::optional<source_location> dbg::lookup_source(uint16_t address) const
+void dbg::console_output(uint8_t c)
 {
-    for (auto &mod : cdb_modules_)
+    // Whole lines only, and only if the dispatcher is idle: a request
+    // handler may be waiting for this thread. Anything held back goes
+    // out when the CPU stops. Replays for reverse execution repeat output
+    // that was sent already.
+    if (replaying_)
+        return;
+    console_buffer_ += static_cast<char>(c);
+    if (c == '\n' && try_send_event(console_event()))
+        console_buffer_.clear();
+}
+
+void dbg::flush_console()
+{
+    if (console_buffer_.empty())
+        return;
+    send_event(console_event());
+    console_buffer_.clear();
+}
+
+void dbg::reset_debug_info()
+{
+    // Source roots are kept: launch sets them again, and unchanged roots
+    // keep the resolved path cache warm across relaunches.
+    cdb_modules_.clear();
+    set_map_symbols({});
+    map_segments_.clear();
+    index_debug_info();
+
+    // Conditions name symbols of the old image; they compile again, with
+    // fresh hit counts, once the new one is indexed.
+    for (auto &entry : source_breakpoints_by_file_)
     {
-        for (auto &ln : mod.lines)
+        for (auto &bp : entry.second)
         {
-            if (ln.address != address)
-                continue;
+            bp.compiled.reset();
+            bp.error.clear();
+        }
+    }
+}
 
-            auto resolved = resolve_source_path(ln.file);
-            if (resolved)
-                return source_location{*resolved, ln.line};
+void dbg::index_debug_info()
+{
+    // Build the address -> line table and the (file, line) -> addresses
+    // index once, so stepping, stack traces and breakpoint resolution
+    // don't scan the CDB/MAP records. CDB lines take precedence over MAP
+    // C$ symbols; within each, the first record for an address wins.
+    // Addresses are physical, wrapped to the configured memory.
+    line_table_.assign(memory_.store().size(), line_entry{});
+    source_files_.clear();
+    line_addresses_.clear();
+
+    std::unordered_map<std::string, uint16_t> file_ids;
+    auto file_id = [&](std::string_view name) -> uint16_t
+    {
+        std::string key(name);
+        auto it = file_ids.find(key);
+        if (it != file_ids.end())
+            return it->second;
+
+        auto resolved = resolve_source_path(key);
+        auto id = static_cast<uint16_t>(source_files_.size());
+        source_files_.push_back(resolved ? *resolved : key);
+        file_ids.emplace(std::move(key), id);
+        return id;
+    };
+
+    for (const auto &mod : cdb_modules_)
+    {
+        for (const auto &ln : mod.lines)
+        {
+            uint32_t address = memory_.wrap(ln.address);
+            add_line_address(line_addresses_, ln.file, ln.line, address);
 
-            return source_location{ln.file, ln.line}; // unresolved fallback
+            auto &entry = line_table_[address];
+            if (entry.line)
+                continue;
+            entry.line = ln.line;
+            entry.file_id = file_id(ln.file);
+            entry.start = address;
         }
     }
 
     // Fallback: map C$<file>$<line>$... symbols from MAP/NOI style names.
+    // Their (file, line) -> address entries are only used for lines the
+    // CDB does not map at all.
+    line_address_index map_addresses;
     for (const auto &sym : map_symbols_)
     {
-        if (sym.address != address)
-            continue;
-
         auto loc = map_symbol_to_source(sym);
         if (!loc)
             continue;
+        uint32_t address = memory_.wrap(sym.address);
+        add_line_address(map_addresses, loc->file, loc->line, address);
 
-        auto resolved = resolve_source_path(loc->file);
-        if (resolved)
-            return source_location{*resolved, loc->line};
+        auto &entry = line_table_[address];
+        if (entry.line)
+            continue;
+        entry.line = loc->line;
+        entry.file_id = file_id(loc->file);
+        entry.start = address;
+    }
 
-        return loc;
+    // Let every line record cover the addresses up to the next record.
+    // Symbols end the range too, so the last line of a C function does
+    // not spill over into the assembly routine linked after it.
+    auto sym = symbols_by_address_.begin();
+    const line_entry *current = nullptr;
+    for (uint32_t addr = 0; addr < line_table_.size(); ++addr)
+    {
+        auto &entry = line_table_[addr];
+        while (sym != symbols_by_address_.end() && sym->address < addr)
+            ++sym;
+        bool label = sym != symbols_by_address_.end() && sym->address == addr;
+
+        if (entry.line)
+            current = &entry;
+        else if (label)
+            current = nullptr;
+        else if (current)
+            entry = *current;
     }
-    return std::nullopt;
+
+    for (auto &[name, lines] : map_addresses)
+    {
+        auto &cdb_lines = line_addresses_[name];
+        for (auto &[line, addresses] : lines)
+            cdb_lines.try_emplace(line, std::move(addresses));
+    }
+
+    index_functions();
 }
 
-std::optional<uint16_t> dbg::lookup_address(const std::string &file, int line) const
+void dbg::index_functions()
 {
-    namespace fs = std::filesystem;
-    std::string query_name = fs::path(file).filename().string();
+    // Function ranges for stack frames: CDB F: records with their L: entry
+    // and end addresses, or MAP G$/F$ symbols paired with their XG$/XF$
+    // end markers when there is no CDB.
+    functions_.clear();
+    for (const auto &mod : cdb_modules_)
+    {
+        for (const auto &fn : mod.functions)
+        {
+            if (fn.has_range)
+                functions_.push_back({fn.name, memory_.wrap(fn.start),
+                                      memory_.wrap(std::max(fn.start, fn.end)),
+                                      fn.stack});
+        }
+    }
 
-    for (auto &mod : cdb_modules_)
+    if (functions_.empty())
     {
-        for (auto &ln : mod.lines)
+        std::unordered_map<std::string_view, const sdcc::symbol *> starts;
+        for (const auto &sym : map_symbols_)
         {
-            if (ln.line != line)
+            if (sym.name.starts_with("G$") || sym.name.starts_with("F"))
+                starts.emplace(sym.name, &sym);
+        }
+        for (const auto &sym : map_symbols_)
+        {
+            if (!sym.name.starts_with("XG$") && !sym.name.starts_with("XF"))
+                continue;
+            auto it = starts.find(std::string_view(sym.name).substr(1));
+            if (it == starts.end() || it->second->address > sym.address)
                 continue;
 
-            // Match by bare filename since CDB stores bare names
-            // and the DAP request sends full paths.
-            std::string cdb_name = fs::path(ln.file).filename().string();
-            if (cdb_name == query_name)
-                return ln.address;
+            // G$<name>$... or F<module>$<name>$...
+            const auto &start = it->second->name;
+            size_t p1 = start.find('$');
+            size_t p2 = start.find('$', p1 + 1);
+            functions_.push_back({start.substr(p1 + 1, p2 - p1 - 1),
+                                  memory_.wrap(it->second->address),
+                                  memory_.wrap(sym.address), 0});
         }
     }
 
-    // Fallback: MAP symbols.
-    for (const auto &sym : map_symbols_)
-    {
-        auto loc = map_symbol_to_source(sym);
-        if (!loc || loc->line != line)
-            continue;
+    std::sort(functions_.begin(), functions_.end(),
+        [](const function_info &a, const function_info &b)
+        { return a.start < b.start; });
+}
 
-        std::string map_name = fs::path(loc->file).filename().string();
-        if (map_name == query_name)
-            return static_cast<uint16_t>(sym.address & 0xFFFF);
-    }
-    return std::nullopt;
+const function_info *dbg::lookup_function(uint32_t address) const
+{
+    auto it = std::upper_bound(
+        functions_.begin(), functions_.end(), address,
+        [](uint32_t a, const function_info &f) { return a < f.start; });
+    if (it == functions_.begin())
+        return nullptr;
+    --it;
+    return address <= it->end ? &*it : nullptr;
 }
 
-std::optional<std::string> dbg::lookup_symbol_exact(uint16_t address) const
+std::vector<uint32_t> dbg::unwind_frame_chain(size_t levels) const
 {
-    const sdcc::symbol *best = nullptr;
-    for (const auto &sym : map_symbols_)
+    // SDCC functions with locals on the stack open with
+    //   push ix / ld ix,#0 / add ix,sp   (8 bytes)
+    // and close with ld sp,ix / pop ix / ret, so inside the body IX points
+    // at the caller's IX with the return address above it and the locals
+    // below, down to IX + frame_size. A caller is trusted only if it has
+    // such a frame itself; functions without one can't be seen through.
+    constexpr uint16_t prologue = 8;
+    std::vector<uint32_t> chain;
+    auto read16 = [this](uint16_t addr)
     {
-        uint16_t sym_addr = static_cast<uint16_t>(sym.address & 0xFFFF);
-        if (sym_addr != address)
-            continue;
+        return static_cast<uint16_t>(memory_.read(addr) |
+                                     (memory_.read(static_cast<uint16_t>(addr + 1)) << 8));
+    };
 
-        if (!best)
-            best = &sym;
-        else if (sym.name.size() > 1 && sym.name[0] == '_')
-            best = &sym; // prefer C-like symbol names for display
+    uint16_t pc = z80ex_get_reg(cpu_, regPC);
+    uint16_t sp = z80ex_get_reg(cpu_, regSP);
+    uint16_t ix = z80ex_get_reg(cpu_, regIX);
+    while (chain.size() < levels)
+    {
+        const function_info *fn = lookup_function(memory_.physical(pc));
+        if (!fn)
+            break;
+        uint16_t offset = static_cast<uint16_t>(memory_.physical(pc) - fn->start);
+
+        uint16_t return_pc;
+        if (chain.empty() && (offset == 0 || memory_.physical(pc) == fn->end))
+        {
+            return_pc = read16(sp);     // Entry or final RET: nothing pushed.
+            sp = static_cast<uint16_t>(sp + 2);
+        }
+        else if (fn->frame_size < 0 && offset >= prologue &&
+                 static_cast<uint16_t>(ix + fn->frame_size) >= sp && ix >= sp)
+        {
+            return_pc = read16(static_cast<uint16_t>(ix + 2));
+            sp = static_cast<uint16_t>(ix + 4);
+            ix = read16(ix);
+        }
+        else
+            break;
+
+        // Show the caller at its call instruction (CALL nn, CALL cc,nn or
+        // RST n); anything else means the chain is broken.
+        uint8_t call = memory_.read(static_cast<uint16_t>(return_pc - 3));
+        uint8_t rst = memory_.read(static_cast<uint16_t>(return_pc - 1));
+        uint16_t call_pc;
+        if (call == 0xCD || (call & 0xC7) == 0xC4)
+            call_pc = static_cast<uint16_t>(return_pc - 3);
+        else if ((rst & 0xC7) == 0xC7)
+            call_pc = static_cast<uint16_t>(return_pc - 1);
+        else
+            break;
+        chain.push_back(memory_.physical(call_pc));
+        pc = call_pc;
     }
+    return chain;
+}
 
-    if (!best)
+std::string dbg::format_hex(uint32_t value, int width)
+{
+    std::ostringstream oss;
+    oss << std::uppercase << std::setfill('0') << std::setw(width)
+        << std::hex << value;
+    return "0x" + oss.str();
+}
+
+std::optional<source_location> dbg::lookup_source(uint32_t address) const
+{
+    if (address >= line_table_.size())
+        return std::nullopt;
+    const auto &entry = line_table_[address];
+    if (!entry.line)
         return std::nullopt;
-    return best->name;
+    return source_location{source_files_[entry.file_id], entry.line, entry.file_id};
 }
 
-std::optional<std::string> dbg::lookup_symbol(uint16_t address) const
+const std::vector<uint32_t> *dbg::lookup_addresses(const std::string &file,
+                                                   int line) const
 {
-    const sdcc::symbol *best = nullptr;
-    uint16_t best_addr = 0;
+    // Match by bare filename since CDB stores bare names
+    // and the DAP request sends full paths.
+    auto by_file = line_addresses_.find(
+        std::filesystem::path(file).filename().string());
+    if (by_file == line_addresses_.end())
+        return nullptr;
+
+    auto by_line = by_file->second.find(line);
+    if (by_line == by_file->second.end())
+        return nullptr;
+    return &by_line->second;
+}
 
-    for (const auto &sym : map_symbols_)
+void dbg::set_map_symbols(std::vector<sdcc::symbol> symbols)
+{
+    map_symbols_ = std::move(symbols);
+    symbols_by_address_.clear();
+
+    std::vector<symbol_entry> entries;
+    entries.reserve(map_symbols_.size());
+    for (uint32_t i = 0; i < map_symbols_.size(); ++i)
     {
-        uint16_t sym_addr = static_cast<uint16_t>(sym.address & 0xFFFF);
-        if (sym_addr > address)
+        if (sdcc::symbol_rank(map_symbols_[i].name) == sdcc::rank_none)
             continue;
+        entries.push_back({memory_.wrap(map_symbols_[i].address), i});
+    }
 
-        if (!best || sym_addr > best_addr)
+    // Sort by address, best display name first, then keep one per address.
+    std::stable_sort(entries.begin(), entries.end(),
+        [this](const symbol_entry &a, const symbol_entry &b)
         {
-            best = &sym;
-            best_addr = sym_addr;
-        }
+            if (a.address != b.address)
+                return a.address < b.address;
+            return sdcc::symbol_rank(map_symbols_[a.index].name) <
+                   sdcc::symbol_rank(map_symbols_[b.index].name);
+        });
+
+    for (const auto &entry : entries)
+    {
+        if (symbols_by_address_.empty() || symbols_by_address_.back().address != entry.address)
+            symbols_by_address_.push_back(entry);
     }
+}
 
-    if (!best)
+std::optional<std::string> dbg::lookup_symbol_exact(uint32_t address) const
+{
+    auto it = std::lower_bound(
+        symbols_by_address_.begin(), symbols_by_address_.end(), address,
+        [](const symbol_entry &e, uint32_t a) { return e.address < a; });
+    if (it == symbols_by_address_.end() || it->address != address)
         return std::nullopt;
+    return map_symbols_[it->index].name;
+}
 
-    std::ostringstream oss;
-    oss << best->name;
-    if (address > best_addr)
-        oss << "+" << (address - best_addr);
-    return oss.str();
+const sdcc::symbol *dbg::lookup_symbol_base(uint32_t address,
+                                            uint32_t *start) const
+{
+    auto it = std::upper_bound(
+        symbols_by_address_.begin(), symbols_by_address_.end(), address,
+        [](uint32_t a, const symbol_entry &e) { return a < e.address; });
+    if (it == symbols_by_address_.begin())
+        return nullptr;
+    --it;
+    if (start)
+        *start = it->address;
+    return &map_symbols_[it->index];
+}
+
+std::optional<std::string> dbg::lookup_symbol(uint32_t address) const
+{
+    uint32_t start = 0;
+    const auto *base = lookup_symbol_base(address, &start);
+    if (!base)
+        return std::nullopt;
+
+    std::string name = base->name;
+    if (address > start)
+        name += "+" + std::to_string(address - start);
+    return name;
+}
+
+void dbg::set_source_root(const std::string &r)
+{
+    if (r == source_root_)
+        return;
+    source_root_ = r;
+    resolved_paths_.clear();
+}
+
+void dbg::set_source_roots(std::vector<std::string> roots)
+{
+    if (roots == source_roots_)
+        return;
+    source_roots_ = std::move(roots);
+    resolved_paths_.clear();
 }
 
 std::optional<std::string> dbg::resolve_source_path(const std::string &path) const
+{
+    auto it = resolved_paths_.find(path);
+    if (it != resolved_paths_.end())
+        return it->second;
+
+    auto resolved = find_source_path(path);
+    resolved_paths_.emplace(path, resolved);
+    return resolved;
+}
+
+std::optional<std::string> dbg::find_source_path(const std::string &path) const
 {
     namespace fs = std::filesystem;
     fs::path p(path);
@@ -291,16 +632,16 @@ std::optional<std::string> dbg::resolve_source_path(const std::string &path) con
 }
 
 void dbg::set_source_breakpoints_for_file(const std::string &file,
-                                          std::vector<int> lines)
+                                          std::vector<source_breakpoint> breakpoints)
 {
     if (file.empty())
         return;
-    if (lines.empty())
+    if (breakpoints.empty())
     {
         source_breakpoints_by_file_.erase(file);
         return;
     }
-    source_breakpoints_by_file_[file] = std::move(lines);
+    source_breakpoints_by_file_[file] = std::move(breakpoints);
 }
 
 std::vector<nlohmann::json> dbg::resolve_source_breakpoints_for_file(
@@ -311,10 +652,16 @@ std::vector<nlohmann::json> dbg::resolve_source_breakpoints_for_file(
     if (it == source_breakpoints_by_file_.end())
         return out;
 
-    for (int line : it->second)
+    for (const auto &bp : it->second)
     {
-        auto addr = lookup_address(file, line);
-        if (addr)
+        int line = bp.line;
+        if (lookup_addresses(file, line) && !bp.error.empty())
+        {
+            out.push_back({{"verified", false},
+                           {"line", line},
+                           {"message", bp.error}});
+        }
+        else if (lookup_addresses(file, line))
         {
             out.push_back({{"verified", true}, {"line", line}});
         }
@@ -334,21 +681,195 @@ std::vector<nlohmann::json> dbg::resolve_source_breakpoints_for_file(
     return out;
 }
 
+// bp_map_ matched at pc. Without bank windows every physical address is
+// its CPU address, so that's a hit; otherwise the breakpoint has to be in
+// the bank currently mapped at pc. A conditional breakpoint stops only if
+// its condition holds and its hit count passes. Every call counts a hit,
+// so callers check each arrival at an address once; replays for reverse
+// execution count again from the counts kept with the snapshot.
+bool dbg::breakpoint_hit(uint16_t pc)
+{
+    if (!memory_.banked() && !(bp_map_[pc] & bp_condition))
+        return true;
+    uint32_t at = memory_.physical(pc);
+    auto it = bp_flags_.find(at);
+    if (it == bp_flags_.end() || !it->second)
+        return false;
+    if (it->second & ~bp_condition)
+        return true;
+
+    auto info = bp_info_.find(at);
+    if (info == bp_info_.end() || !info->second.condition)
+        return true;
+    auto &bc = *info->second.condition;
+    if (bc.condition && !bc.condition->evaluate(cpu_, memory_))
+        return false;
+    if (!bc.hit)
+        return true;
+    return bc.hit->test(++bc.hits);
+}
+
+void dbg::set_breakpoint_flag(uint32_t address, uint8_t flag)
+{
+    bp_flags_[address] |= flag;
+    bp_map_[address & 0xFFFF] |= flag;
+}
+
+void dbg::clear_breakpoint_flag(const std::vector<uint32_t> &addresses,
+                                uint8_t flag)
+{
+    for (uint32_t addr : addresses)
+    {
+        auto it = bp_flags_.find(addr);
+        if (it == bp_flags_.end())
+            continue;
+        it->second &= static_cast<uint8_t>(~flag);
+        if (!(it->second & (bp_source | bp_condition)))
+            bp_info_.erase(addr);
+        if (!it->second)
+            bp_flags_.erase(it);
+
+        // Other banks may still have the flag at the same CPU address.
+        uint16_t cpu = static_cast<uint16_t>(addr & 0xFFFF);
+        bp_map_[cpu] &= static_cast<uint8_t>(~flag);
+        for (uint32_t bank = 0; bank < 0x100; ++bank)
+        {
+            auto other = bp_flags_.find((bank << 16) | cpu);
+            if (other != bp_flags_.end())
+                bp_map_[cpu] |= other->second & flag;
+        }
+    }
+}
+
+uint8_t dbg::breakpoint_at(uint32_t address) const
+{
+    auto it = bp_flags_.find(address);
+    return it == bp_flags_.end() ? 0 : it->second;
+}
+
+const breakpoint_info *dbg::breakpoint_info_at(uint32_t address) const
+{
+    auto it = bp_info_.find(address);
+    if (it == bp_info_.end())
+        return nullptr;
+    return &it->second;
+}
+
+void dbg::set_instruction_breakpoints(std::vector<uint32_t> addresses)
+{
+    clear_breakpoint_flag(instruction_breakpoints_, bp_instruction);
+    instruction_breakpoints_.clear();
+
+    for (uint32_t addr : addresses)
+    {
+        addr = memory_.wrap(addr);
+        if (breakpoint_at(addr) & bp_instruction)
+            continue;
+        set_breakpoint_flag(addr, bp_instruction);
+        instruction_breakpoints_.push_back(addr);
+    }
+}
+
+void dbg::set_data_breakpoints(std::vector<data_breakpoint> breakpoints)
+{
+    memory_.clear_watches();
+    data_breakpoints_ = std::move(breakpoints);
+    for (auto &bp : data_breakpoints_)
+    {
+        bp.address = memory_.wrap(bp.address);
+        for (uint32_t page = bp.address >> memory_map::page_bits;
+             page <= (bp.address + bp.size - 1) >> memory_map::page_bits; ++page)
+            memory_.watch(page << memory_map::page_bits, bp.access);
+    }
+}
+
+std::optional<variable_info> dbg::lookup_variable(const std::string &name) const
+{
+    // SDCC prefixes C names with an underscore in the MAP.
+    std::string c_name = name.size() > 1 && name[0] == '_' ? name.substr(1) : name;
+    const sdcc::symbol *found = nullptr;
+    for (const auto &sym : map_symbols_)
+    {
+        if (sym.name == "_" + c_name)
+        {
+            found = &sym;
+            break;
+        }
+        if (!found && sym.name == name)
+            found = &sym;
+    }
+    if (!found)
+        return std::nullopt;
+
+    variable_info var{name, memory_.wrap(found->address), 1};
+    // Type info starts with the size in braces, e.g. "{2}SI:S".
+    for (const auto &module : cdb_modules_)
+    {
+        for (const auto &sym : module.global_symbols)
+        {
+            if (sym.name != c_name || !sym.type_info.starts_with('{'))
+                continue;
+            unsigned size = 0;
+            if (std::sscanf(sym.type_info.c_str(), "{%u}", &size) == 1 && size)
+                var.size = static_cast<uint16_t>(std::min(size, 0xFFFFu));
+            return var;
+        }
+    }
+    return var;
+}
+
 void dbg::rebuild_source_breakpoint_addresses()
 {
-    breakpoints_.clear();
-    std::unordered_set<uint16_t> seen;
+    clear_breakpoint_flag(source_breakpoints_, bp_source | bp_condition);
+    source_breakpoints_.clear();
+    hit_counted_.clear();
 
-    for (const auto &entry : source_breakpoints_by_file_)
+    auto resolve = [this](const std::string &name) -> std::optional<uint32_t>
+    {
+        if (auto var = lookup_variable(name))
+            return var->address;
+        return std::nullopt;
+    };
+
+    for (auto &entry : source_breakpoints_by_file_)
     {
         const auto &file = entry.first;
-        for (int line : entry.second)
+        for (auto &bp : entry.second)
         {
-            auto addr = lookup_address(file, line);
-            if (!addr)
+            auto addresses = lookup_addresses(file, bp.line);
+            if (!addresses)
                 continue;
-            if (seen.insert(*addr).second)
-                breakpoints_.push_back(*addr);
+
+            // Compile once; the breakpoint keeps its code and hit count
+            // until the client sets it again or the image is reloaded.
+            bool conditional = !bp.condition.empty() || !bp.hit_condition.empty();
+            if (conditional && !bp.compiled && bp.error.empty())
+            {
+                auto compiled = std::make_shared<breakpoint_condition>();
+                std::string error;
+                if (!bp.condition.empty() &&
+                    !(compiled->condition = expression::compile(bp.condition, resolve, error)))
+                    bp.error = "Invalid condition: " + error;
+                else if (!bp.hit_condition.empty() &&
+                         !(compiled->hit = hit_condition::parse(bp.hit_condition)))
+                    bp.error = "Invalid hit condition '" + bp.hit_condition + "'";
+                else
+                    bp.compiled = std::move(compiled);
+            }
+            if (!bp.error.empty())
+                continue;
+            if (bp.compiled && bp.compiled->hit)
+                hit_counted_.push_back(bp.compiled);
+
+            uint8_t flag = conditional ? bp_condition : bp_source;
+            for (uint32_t addr : *addresses)
+            {
+                if (breakpoint_at(addr) & (bp_source | bp_condition))
+                    continue;
+                set_breakpoint_flag(addr, flag);
+                bp_info_[addr] = breakpoint_info{file, bp.line, bp.compiled};
+                source_breakpoints_.push_back(addr);
+            }
         }
     }
 }
@@ -400,9 +921,5 @@ std::optional<source_content> dbg::source_by_reference(int source_reference) con
 
 uint8_t dbg::dasm_readbyte_cb(Z80EX_WORD addr, void *user_data)
 {
-    auto *memory = static_cast<std::vector<uint8_t> *>(user_data);
-    if (addr < memory->size())
-        return (*memory)[addr];
-    else
-        return 0xFF;
+    return static_cast<const memory_map *>(user_data)->read(addr);
 }
@@ -10,8 +10,12 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <deque>
 #include <functional>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
@@ -22,6 +26,7 @@
 #include <filesystem>
 #include <optional>
 #include <unordered_map>
+#include <memory>
 
 #include <nlohmann/json.hpp>
 #include <sdcc/cdbg_info.h>
@@ -30,10 +35,112 @@
 #include <z80ex.h>
 #include <z80ex_dasm.h>
 #include <dap/dap.h>
+#include <platform/interrupts.h>
+#include <platform/io_bus.h>
+#include <platform/scheduler.h>
+#include <platform/sio.h>
+#include <coverage.h>
+#include <expression.h>
+#include <memory_map.h>
+#include <profiler.h>
 
+// Source line covering an address. `file` points into the debugger's file
+// table and stays valid until debug info is reloaded.
 struct source_location {
-    std::string file;
+    std::string_view file;
     int line;
+    uint16_t file_id = 0;
+};
+
+// Physical address range of a function, from CDB function records (or
+// MAP G$/XG$ symbol pairs when there is no CDB).
+struct function_info {
+    std::string name;
+    uint32_t start = 0;
+    uint32_t end = 0;       // Address of the last instruction.
+    int frame_size = 0;     // CDB frame size (e.g. -6: locals from IX-6),
+                            // 0 if unknown or without an IX frame.
+};
+
+// Shadow call stack entry, pushed by the CPU loop for every taken CALL or
+// RST and popped once SP moves above the slot holding the return address.
+struct call_frame {
+    uint32_t call_pc;       // Physical address of the call instruction.
+    uint16_t return_pc;
+    uint16_t sp;            // SP after the call.
+};
+
+// Breakpoint map flags, one byte per CPU address. The CPU loop tests the
+// whole byte, so any non-zero value means "stop here" (once the bank and
+// any condition are checked, see dbg::breakpoint_hit).
+enum breakpoint_flags : uint8_t {
+    bp_source = 0x01,
+    bp_instruction = 0x02,
+    bp_condition = 0x04,    // Source breakpoint with a condition or hit count.
+    bp_temp = 0x80,         // Stepping engine: return address of a call.
+};
+
+// Kinds of execution the execution thread can perform.
+enum class exec_mode {
+    run,            // Free-run until a breakpoint or pause.
+    step_over,      // Next: run to the next line, stepping over calls.
+    step_in,        // Step in: run to the next line, entering calls.
+    step_out,       // Step out: run until the current function returns.
+    step_back,      // Step back: to the start of the previous line.
+    reverse_continue, // Run backwards to the previous breakpoint.
+};
+
+// Machine state at an instruction boundary, without the memory contents:
+// CPU registers, bank selection, device state and the shadow call stack.
+// Reverse execution keeps memory in its write journal (see history.cpp).
+struct machine_state {
+    uint64_t steps = 0;         // Instructions executed (dbg::steps()).
+    uint64_t tstates = 0;
+    std::array<uint16_t, regIFF2 + 1> registers{};  // By Z80_REG_T.
+    std::vector<uint8_t> banks;     // Selected bank of each window.
+    std::vector<uint8_t> devices;   // io_device::save() of every device,
+                                    // then the interrupt chain.
+    std::vector<call_frame> call_stack;
+};
+
+// Data breakpoint on a range of physical addresses.
+struct data_breakpoint {
+    uint32_t address = 0;
+    uint16_t size = 1;
+    uint8_t access = memory_map::watch_write;   // memory_map watch flags.
+    std::string name;       // Variable or address, for stop descriptions.
+};
+
+// A global variable resolved from the MAP, sized from its CDB type.
+struct variable_info {
+    std::string name;
+    uint32_t address = 0;   // Physical.
+    uint16_t size = 1;      // 1 if the CDB doesn't give the type.
+};
+
+// Compiled condition and hit count of a source breakpoint, shared by all
+// the addresses of its line.
+struct breakpoint_condition {
+    std::optional<expression> condition;
+    std::optional<hit_condition> hit;
+    uint64_t hits = 0;
+};
+
+// Source breakpoint as set by the client. `compiled` is built from the
+// text when the breakpoint addresses are rebuilt; `error` says why not.
+struct source_breakpoint {
+    int line = 0;
+    std::string condition;
+    std::string hit_condition;
+    std::shared_ptr<breakpoint_condition> compiled;
+    std::string error;
+};
+
+// Per-address breakpoint metadata (side table of the breakpoint map).
+struct breakpoint_info {
+    std::string file;   // Source breakpoint file, as sent by the client.
+    int line = 0;       // Source breakpoint line.
+    std::shared_ptr<breakpoint_condition> condition;    // bp_condition only.
 };
 
 struct source_content {
@@ -55,13 +162,145 @@ public:
     // Event sending (set by main before running the dispatcher).
     void set_event_sender(std::function<void(const std::string &)> sender);
     void send_event(const std::string &event_json);
+    // Non-blocking sender for the execution thread, which must not wait
+    // for the dispatcher while a request handler may be waiting for it.
+    void set_try_event_sender(std::function<bool(const std::string &)> sender);
+    bool try_send_event(const std::string &event_json);
+    void send_stopped_event(const std::string &reason,
+                            const std::string &description = {});
+
+    // Execution control (see execution.cpp). The CPU runs on a dedicated
+    // thread until a breakpoint, the end of a step, a pause request or a
+    // HALT with interrupts disabled; the stop is reported via a stopped
+    // event. Steps are source-level when the PC maps to a source line
+    // and `instruction` is false, otherwise instruction-level. Steps only
+    // start from a stopped CPU: start_step returns false while it runs.
+    void start_execution();
+    bool start_step(exec_mode mode, bool instruction);
+    bool request_pause();
+    bool stop_execution();
+    bool park_execution();
+    void unpark_execution();
+    bool running() const;
+
+    // Shadow call stack, innermost call last. Only stable while the
+    // execution thread is stopped or parked.
+    const std::vector<call_frame> &call_stack() const { return call_stack_; }
+    void reset_call_stack()
+    {
+        call_stack_.clear();
+        call_graph_.reset_path();
+    }
+    // Call instructions (physical, innermost first) recovered from SDCC's
+    // IX frame chain, for when the shadow stack has nothing: after a reset
+    // of the stack, or in code entered before tracking began.
+    std::vector<uint32_t> unwind_frame_chain(size_t levels) const;
+
+    // (source basename, line) -> every physical address generated for
+    // that line.
+    using line_address_index = std::unordered_map<
+        std::string, std::unordered_map<int, std::vector<uint32_t>>>;
 
     // Accessors for handler classes.
     Z80EX_CONTEXT *cpu() { return cpu_; }
-    std::vector<uint8_t> &memory() { return memory_; }
-    const std::vector<uint8_t> &memory() const { return memory_; }
-    std::vector<uint16_t> &breakpoints() { return breakpoints_; }
-    std::vector<uint16_t> &instruction_breakpoints() { return instruction_breakpoints_; }
+    memory_map &memory() { return memory_; }
+    const memory_map &memory() const { return memory_; }
+    platform::io_bus &io() { return io_; }
+    // T-state clock of the CPU and the device events scheduled on it.
+    platform::scheduler &scheduler() { return scheduler_; }
+    platform::interrupt_chain &interrupts() { return interrupts_; }
+
+    // Devices on the I/O bus are owned by dbg and replaced on launch,
+    // which also empties the interrupt chain.
+    bool attach_device(uint8_t first, unsigned count,
+                       std::unique_ptr<platform::io_device> device);
+    void clear_devices();
+    // Console device output, sent as DAP output events a line at a time
+    // when the dispatcher is idle, and in full whenever the CPU stops.
+    // Called on the execution thread.
+    void console_output(uint8_t c);
+    // The console device host input goes to (the first SIO attached), or
+    // nullptr. Queue input only while the execution thread is parked.
+    platform::sio *console() { return console_; }
+    void set_console(platform::sio *device) { console_ = device; }
+
+    // Execution profile and call graph (see profiler.h). Switch profiling
+    // and read the results only while the execution thread is stopped or
+    // parked.
+    void set_profiling(bool on, bool calls = false);
+    bool profiling() const { return instruments_ & instrument_profile; }
+    bool profiling_calls() const { return instruments_ & instrument_calls; }
+    exec_profile &profile() { return profile_; }
+    const exec_profile &profile() const { return profile_; }
+    ::call_graph &call_graph() { return call_graph_; }
+    const ::call_graph &call_graph() const { return call_graph_; }
+    // Sample the PC every `interval` T-states into a fresh buffer of
+    // `capacity` samples. Stopping keeps the buffer.
+    void start_sampling(uint32_t interval, size_t capacity);
+    void stop_sampling();
+    bool sampling() const { return sample_timer_ && sample_timer_->armed(); }
+    pc_sampler &sampler() { return sampler_; }
+    const pc_sampler &sampler() const { return sampler_; }
+
+    // Code coverage (see coverage.h), written to coverage_path() on
+    // disconnect. Same threading rules as profiling.
+    void set_coverage(bool on);
+    bool covering() const { return instruments_ & instrument_coverage; }
+    exec_coverage &coverage() { return coverage_; }
+    const exec_coverage &coverage() const { return coverage_; }
+    const std::string &coverage_path() const { return coverage_path_; }
+    void set_coverage_path(const std::string &p) { coverage_path_ = p; }
+
+    // Reverse execution (see history.cpp). While recording, the CPU loop
+    // keeps a machine_state every `interval` T-states and the old value of
+    // every memory write, within `budget` bytes: the oldest history is
+    // dropped first. Steps back replay forward from the nearest state.
+    void start_recording(uint64_t interval, size_t budget);
+    void stop_recording();
+    bool recording() const { return recording_; }
+    // Drops the history and records on from here with the same settings,
+    // when state the replays can't reproduce came from outside: loaded
+    // snapshots, input injected into a device. No-op while not recording.
+    void restart_recording();
+    // Called by the memory write callback while recording, before the
+    // write.
+    void journal_write(uint16_t addr)
+    {
+        uint32_t at = memory_.physical(addr);
+        journal_.push_back(at << 8 | memory_.store()[at]);
+    }
+    // Instructions executed so far (the position in the history).
+    uint64_t steps() const { return steps_; }
+    // Capture or restore everything but memory. Only while the execution
+    // thread is stopped or parked. Restoring fails if the device state
+    // was saved from a different machine.
+    void capture_state(machine_state &state) const;
+    bool restore_state(const machine_state &state);
+
+    // Machine snapshots (see snapshot.cpp): the whole machine as a compact
+    // blob, with memory stored as its differences from the image loaded at
+    // launch. Only while the execution thread is stopped. Loading fails,
+    // leaving the machine as it was, for a blob from another program image
+    // or machine.
+    std::vector<uint8_t> save_snapshot() const;
+    bool load_snapshot(const std::vector<uint8_t> &blob, std::string &error);
+    // Called by launch once the program is loaded: the image snapshots are
+    // compared with, and the state restart() goes back to.
+    void set_restart_point();
+    bool restart(std::string &error);
+
+    // Breakpoints are kept by physical address (see memory_map.h).
+    uint8_t breakpoint_at(uint32_t address) const;
+    const breakpoint_info *breakpoint_info_at(uint32_t address) const;
+    const std::vector<uint32_t> &instruction_breakpoints() const { return instruction_breakpoints_; }
+    void set_instruction_breakpoints(std::vector<uint32_t> addresses);
+    // Data breakpoints. Accesses to watched pages go to data_access() from
+    // the memory callbacks; a hit stops the CPU after the instruction.
+    void set_data_breakpoints(std::vector<data_breakpoint> breakpoints);
+    const std::vector<data_breakpoint> &data_breakpoints() const { return data_breakpoints_; }
+    void data_access(uint16_t addr, uint8_t access, uint8_t value);
+    // Global variable by C name ("counter") or MAP label ("_counter").
+    std::optional<variable_info> lookup_variable(const std::string &name) const;
     int next_event_seq() { return event_seq_++; }
     bool launched() const { return launched_; }
     void set_launched(bool v) { launched_ = v; }
@@ -73,25 +312,36 @@ public:
     void set_virtual_lst_source_reference(int r) { virtual_lst_source_reference_ = r; }
 
     // CDB debug info.
+    void reset_debug_info();
+    void index_debug_info();
     void set_cdb_modules(std::vector<sdcc::cdbg_info_module> m) { cdb_modules_ = std::move(m); }
     const std::vector<sdcc::cdbg_info_module> &cdb_modules() const { return cdb_modules_; }
     bool has_cdb() const { return !cdb_modules_.empty(); }
-    void set_source_root(const std::string &r) { source_root_ = r; }
+    void set_source_root(const std::string &r);
     const std::string &source_root() const { return source_root_; }
-    void set_source_roots(std::vector<std::string> roots) { source_roots_ = std::move(roots); }
+    void set_source_roots(std::vector<std::string> roots);
     const std::vector<std::string> &source_roots() const { return source_roots_; }
-    void set_map_symbols(std::vector<sdcc::symbol> symbols) { map_symbols_ = std::move(symbols); }
+    void set_map_symbols(std::vector<sdcc::symbol> symbols);
     const std::vector<sdcc::symbol> &map_symbols() const { return map_symbols_; }
     void set_map_segments(std::vector<sdcc::segment> segments) { map_segments_ = std::move(segments); }
     const std::vector<sdcc::segment> &map_segments() const { return map_segments_; }
     bool has_map() const { return !map_symbols_.empty() || !map_segments_.empty(); }
-    std::optional<source_location> lookup_source(uint16_t address) const;
-    std::optional<uint16_t> lookup_address(const std::string &file, int line) const;
-    std::optional<std::string> lookup_symbol_exact(uint16_t address) const;
-    std::optional<std::string> lookup_symbol(uint16_t address) const;
+    // Lookups take and return physical addresses; translate CPU addresses
+    // with memory().physical() first.
+    std::optional<source_location> lookup_source(uint32_t address) const;
+    const std::vector<uint32_t> *lookup_addresses(const std::string &file,
+                                                  int line) const;
+    const function_info *lookup_function(uint32_t address) const;
+    const std::vector<function_info> &functions() const { return functions_; }
+    std::optional<std::string> lookup_symbol_exact(uint32_t address) const;
+    std::optional<std::string> lookup_symbol(uint32_t address) const;
+    // The MAP label at or below `address` (what lookup_symbol() names it
+    // after) and its physical address in `start`, or nullptr.
+    const sdcc::symbol *lookup_symbol_base(uint32_t address,
+                                           uint32_t *start = nullptr) const;
     std::optional<std::string> resolve_source_path(const std::string &path) const;
     void set_source_breakpoints_for_file(const std::string &file,
-                                         std::vector<int> lines);
+                                         std::vector<source_breakpoint> breakpoints);
     std::vector<nlohmann::json> resolve_source_breakpoints_for_file(
         const std::string &file) const;
     void rebuild_source_breakpoint_addresses();
@@ -104,17 +354,36 @@ public:
     static uint8_t dasm_readbyte_cb(Z80EX_WORD addr, void *user_data);
 
     // Formatting helper.
-    std::string format_hex(uint16_t value, int width);
+    std::string format_hex(uint32_t value, int width);
 
 private:
     Z80EX_CONTEXT *cpu_;
-    std::vector<uint8_t> memory_;
-    std::vector<uint16_t> breakpoints_;
-    std::vector<uint16_t> instruction_breakpoints_;
-    int event_seq_;
+    memory_map memory_;
+    platform::io_bus io_;
+    platform::scheduler scheduler_;
+    platform::interrupt_chain interrupts_;
+    // Declared after the scheduler: devices cancel their timers on
+    // destruction.
+    std::vector<std::unique_ptr<platform::io_device>> devices_;
+    platform::sio *console_ = nullptr;     // One of devices_.
+    std::string console_buffer_;
+    // bp_map_ holds the flags of every bank's breakpoints at each CPU
+    // address, so the CPU loop needs a single load per instruction; the
+    // flags per physical address are in bp_flags_.
+    std::vector<uint8_t> bp_map_;
+    std::unordered_map<uint32_t, uint8_t> bp_flags_;
+    std::unordered_map<uint32_t, breakpoint_info> bp_info_;
+    std::vector<uint32_t> source_breakpoints_;
+    // Conditions with a hit count, whose counts the history keeps.
+    std::vector<std::shared_ptr<breakpoint_condition>> hit_counted_;
+    std::vector<uint32_t> instruction_breakpoints_;
+    std::vector<data_breakpoint> data_breakpoints_;
+    std::string data_hit_;      // Description of the data breakpoint hit.
+    std::atomic<int> event_seq_;
     bool launched_;
     bool pending_entry_stop_ = false;
     std::function<void(const std::string &)> send_event_;
+    std::function<bool(const std::string &)> try_send_event_;
 
     std::string virtual_lst_path_ = "/__virtual__/listing.lst";
     int virtual_lst_source_reference_ = 1;
@@ -122,11 +391,154 @@ private:
     std::vector<sdcc::cdbg_info_module> cdb_modules_;
     std::string source_root_;
     std::vector<std::string> source_roots_;
+    // Memoized resolve_source_path results (including misses), keyed by
+    // the raw name. Cleared whenever the search roots change.
+    mutable std::unordered_map<std::string, std::optional<std::string>> resolved_paths_;
     std::vector<sdcc::symbol> map_symbols_;
+    // Address-sorted view of map_symbols_ with one display name per
+    // address, built when the MAP is loaded. Line markers (C$, A$, XG$...)
+    // and area lengths are left out: they never make a useful label.
+    struct symbol_entry {
+        uint32_t address;
+        uint32_t index;     // Into map_symbols_.
+    };
+    std::vector<symbol_entry> symbols_by_address_;
     std::vector<sdcc::segment> map_segments_;
-    std::unordered_map<std::string, std::vector<int>> source_breakpoints_by_file_;
+
+    // Physical address -> source line index, one entry per address of the
+    // physical store (line 0 means unmapped). Each line record covers the
+    // addresses from its own up to the next line record or symbol; `start`
+    // is the address of the covering record, so an address begins a line
+    // when start == address. File ids index source_files_, which holds the
+    // resolved path of every source file named by the debug info.
+    struct line_entry {
+        int line = 0;
+        uint16_t file_id = 0;
+        uint32_t start = 0;
+    };
+    std::vector<line_entry> line_table_;
+    std::vector<std::string> source_files_;
+    line_address_index line_addresses_;
+    std::vector<function_info> functions_;     // Sorted by start.
+    std::unordered_map<std::string, std::vector<source_breakpoint>> source_breakpoints_by_file_;
 
     std::unordered_map<int, source_content> source_ref_to_content_;
     std::unordered_map<std::string, int> source_path_to_ref_;
     int next_source_reference_ = 1000;
+
+    // Execution thread state.
+    enum class stop_request { none, pause, silent, park, data };
+    struct step_plan {
+        exec_mode mode = exec_mode::run;
+        bool instruction = false;   // Stop after one instruction.
+        uint32_t lo = 0;            // Physical address range of the
+        uint32_t hi = 0;            // source line being stepped.
+        uint16_t sp = 0;            // SP when the step began.
+        uint16_t frame_sp = 0;      // SP just after the call into the
+                                    // frame the step began in.
+        size_t depth = 0;           // Call depth when the step began.
+    };
+    void index_functions();
+    std::string console_event();
+    void flush_console();
+    void execution_main();
+    bool step_instruction();
+    void instrument(uint16_t pc, unsigned tstates);
+    void take_sample(uint64_t at);
+    void push_call_frame(uint16_t call_pc, uint16_t return_pc, uint16_t sp);
+    bool accept_interrupt();
+    void resume_locked(const step_plan &plan);
+    std::optional<const char *> poll_stop();
+    bool halted_for_good(std::string &description);
+    const char *run_until_stop(std::string &description);
+    const char *run_free(std::string &description);
+    const char *run_step(std::string &description);
+    std::optional<const char *> run_to_return(uint16_t return_pc,
+                                              uint16_t sp,
+                                              std::string &description);
+    void take_snapshot(uint8_t op);
+    void trim_history();
+    void rewind(size_t snapshot);
+    std::optional<const char *> replay_to(uint64_t steps);
+    bool reverse_stop_here();
+    const char *run_reverse(std::string &description);
+    std::optional<std::string> find_source_path(const std::string &path) const;
+    bool breakpoint_hit(uint16_t pc);
+    void set_breakpoint_flag(uint32_t address, uint8_t flag);
+    void clear_breakpoint_flag(const std::vector<uint32_t> &addresses,
+                               uint8_t flag);
+
+    std::thread exec_thread_;
+    mutable std::mutex exec_mutex_;
+    std::condition_variable exec_cv_;
+    bool exec_running_ = false;
+    bool exec_parked_ = false;
+    bool exec_quit_ = false;
+    std::atomic<stop_request> stop_request_{stop_request::none};
+    step_plan plan_;
+
+    // Deeper calls drop the outermost frames, so code that never returns
+    // (or switches stacks by hand) can't grow the stack without bound.
+    static constexpr size_t max_call_depth = 1024;
+    std::vector<call_frame> call_stack_;
+
+    // Instrumentation run by the CPU loop after each instruction; the loop
+    // tests the whole byte, so it costs one branch while everything is off.
+    enum instrument_flags : uint8_t {
+        instrument_profile = 0x01,
+        instrument_calls = 0x02,
+        instrument_coverage = 0x04,
+    };
+    uint8_t instruments_ = 0;
+    exec_profile profile_;
+    ::call_graph call_graph_;
+    pc_sampler sampler_;
+    exec_coverage coverage_;
+    std::string coverage_path_;
+    std::optional<platform::scheduler::timer> sample_timer_;
+
+    // Reverse execution history. Journal entries are (physical address
+    // << 8) | old value, numbered from journal_base_; each snapshot
+    // records how many entries preceded it.
+    struct snapshot {
+        machine_state state;
+        uint64_t journal = 0;
+        size_t bytes = 0;
+        std::vector<std::pair<std::shared_ptr<breakpoint_condition>, uint64_t>> hits;
+    };
+    bool recording_ = false;
+    bool replaying_ = false;
+    uint64_t steps_ = 0;
+    uint64_t snapshot_interval_ = 0;
+    uint64_t next_snapshot_ = UINT64_MAX;
+    size_t history_budget_ = 0;
+    size_t snapshot_bytes_ = 0;
+    std::deque<snapshot> snapshots_;
+    std::deque<uint32_t> journal_;
+    uint64_t journal_base_ = 0;
+
+    std::vector<uint8_t> base_image_;
+    uint64_t base_hash_ = 0;
+    std::vector<uint8_t> restart_point_;
+};
+
+// Parks the execution thread in place for the lifetime of the object,
+// without reporting a stop to the client, so an in-flight continue or
+// step carries on afterwards. Used by handlers that mutate state the CPU
+// loop reads.
+class execution_pause {
+public:
+    explicit execution_pause(dbg &ctx)
+        : ctx_(ctx), parked_(ctx.park_execution()) {}
+    ~execution_pause()
+    {
+        if (parked_)
+            ctx_.unpark_execution();
+    }
+    execution_pause(const execution_pause &) = delete;
+    execution_pause &operator=(const execution_pause &) = delete;
+
+private:
+    dbg &ctx_;
+    bool parked_;
 };
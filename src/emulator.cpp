@@ -9,35 +9,52 @@
 // MIT License.
 #include <dbg.h>
 
+// Opcode fetches (M1 cycles) don't count as reads for data breakpoints.
 static uint8_t memread_cb(Z80EX_CONTEXT *, uint16_t addr,
     int m1_state, void *user_data)
 {
     auto *dbg_ptr = static_cast<dbg *>(user_data);
-    return dbg_ptr->memory()[addr];
+    uint8_t value = dbg_ptr->memory().read(addr);
+    if ((dbg_ptr->memory().watched(addr) & memory_map::watch_read) && !m1_state)
+        dbg_ptr->data_access(addr, memory_map::watch_read, value);
+    return value;
 }
 
 static void memwrite_cb(Z80EX_CONTEXT *, uint16_t addr,
     uint8_t value, void *user_data)
 {
     auto *dbg_ptr = static_cast<dbg *>(user_data);
-    dbg_ptr->memory()[addr] = value;
+    if (dbg_ptr->recording())
+        dbg_ptr->journal_write(addr);
+    if (dbg_ptr->memory().watched(addr) & memory_map::watch_write)
+        dbg_ptr->data_access(addr, memory_map::watch_write, value);
+    dbg_ptr->memory().write(addr, value);
 }
 
-static uint8_t portread_cb(Z80EX_CONTEXT *, uint16_t, void *)
+static uint8_t portread_cb(Z80EX_CONTEXT *, uint16_t port, void *user_data)
 {
-    return 0xFF;
+    auto *dbg_ptr = static_cast<dbg *>(user_data);
+    return dbg_ptr->io().read(port);
 }
 
-static void portwrite_cb(Z80EX_CONTEXT *, uint16_t, uint8_t, void *) {}
+static void portwrite_cb(Z80EX_CONTEXT *, uint16_t port, uint8_t value,
+    void *user_data)
+{
+    auto *dbg_ptr = static_cast<dbg *>(user_data);
+    dbg_ptr->io().write(port, value);
+}
 
-static uint8_t intread_cb(Z80EX_CONTEXT *, void *)
+// Interrupt acknowledge cycle (IM 0 and IM 2): the vector of the highest
+// priority request on the daisy chain.
+static uint8_t intread_cb(Z80EX_CONTEXT *, void *user_data)
 {
-    return 0;
+    auto *dbg_ptr = static_cast<dbg *>(user_data);
+    return dbg_ptr->interrupts().vector();
 }
 
 dbg::dbg()
-    : cpu_(nullptr), memory_(0x10000, 0),
-      breakpoints_(), event_seq_(1), launched_(false)
+    : cpu_(nullptr), bp_map_(0x10000, 0),
+      event_seq_(1), launched_(false), line_table_(0x10000)
 {
     cpu_ = z80ex_create(
         memread_cb, this,
@@ -49,6 +66,15 @@ dbg::dbg()
 
 dbg::~dbg()
 {
+    stop_execution();
+    {
+        std::lock_guard<std::mutex> lock(exec_mutex_);
+        exec_quit_ = true;
+        exec_cv_.notify_all();
+    }
+    if (exec_thread_.joinable())
+        exec_thread_.join();
+
     if (cpu_)
         z80ex_destroy(cpu_);
 }
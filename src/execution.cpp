@@ -0,0 +1,572 @@
+// execution.cpp
+// Background execution thread for running and stepping the emulated Z80.
+//
+// This file implements the execution control functions of the `dbg` class.
+// A single long-lived thread runs the CPU while the DAP dispatcher keeps
+// serving requests; it stops on breakpoints, at the end of a step, on
+// pause requests and when the CPU halts with interrupts disabled, and
+// reports the stop through a DAP "stopped" event.
+//
+// Source-level steps run natively until the PC leaves the address range
+// of the current line (taken from the CDB line table). Calls are stepped
+// over by planting a temporary breakpoint on the return address, and
+// stepping out watches for a return that lifts SP above its value at the
+// start of the step. Like gdb, step in only enters calls into code that
+// has line info.
+//
+// Every loop executes through step_instruction(), which runs a whole
+// instruction (z80ex returns after a bare DD/FD prefix, and nothing may
+// stop the CPU between a prefix and what it modifies) and keeps a shadow
+// call stack for stack traces: taken calls and accepted interrupts push a
+// frame, and frames are dropped as soon as SP rises above the slot holding
+// their return address (a RET, or the program resetting its stack). It
+// also advances the T-state clock, fires device events that are due and
+// lets the CPU accept pending interrupts; with nothing scheduled and no
+// interrupt requested that costs two compares per instruction. Profilers
+// hook in after the instruction, behind a single test while they're off;
+// the call graph profiler also follows the shadow call stack. The PC
+// sampler is a scheduler timer and costs nothing per instruction.
+// Recording for reverse execution adds a compare with the time of the
+// next snapshot (see history.cpp).
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dbg.h>
+
+namespace {
+
+// Stop reason for data breakpoints, whose description comes from the
+// memory callback that hit one.
+constexpr const char *data_breakpoint_reason = "data breakpoint";
+
+// Length of the call instruction with opcode `op` (CALL nn, CALL cc,nn,
+// RST n), or 0 if it is not a call.
+int call_length(uint8_t op)
+{
+    if (op == 0xCD || (op & 0xC7) == 0xC4)
+        return 3;
+    if ((op & 0xC7) == 0xC7)
+        return 1;
+    return 0;
+}
+
+// True for RET, RET cc, RETI and RETN (including the ED mirrors).
+bool is_return(uint8_t op, uint8_t next)
+{
+    if (op == 0xC9 || (op & 0xC7) == 0xC0)
+        return true;
+    return op == 0xED && (next & 0xC7) == 0x45;
+}
+
+// True if `sp` lies above `base` on the (wrapping) 16-bit stack.
+bool sp_above(uint16_t sp, uint16_t base)
+{
+    return static_cast<int16_t>(sp - base) > 0;
+}
+
+} // namespace
+
+void dbg::start_execution()
+{
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    resume_locked(step_plan{});
+}
+
+bool dbg::start_step(exec_mode mode, bool instruction)
+{
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    if (exec_running_)
+        return false;
+
+    step_plan plan;
+    plan.mode = mode;
+    plan.sp = z80ex_get_reg(cpu_, regSP);
+    plan.depth = call_stack_.size();
+    // Without a shadow frame (code entered before tracking began) the
+    // best guess is that the stack holds nothing but the return address.
+    plan.frame_sp = call_stack_.empty() ? plan.sp : call_stack_.back().sp;
+
+    uint32_t pc = memory_.physical(z80ex_get_reg(cpu_, regPC));
+    const auto &entry = line_table_[pc];
+    plan.instruction = instruction || !entry.line;
+    if (!plan.instruction)
+    {
+        plan.lo = entry.start;
+        plan.hi = pc;
+        while (plan.hi < line_table_.size() && line_table_[plan.hi].line &&
+               line_table_[plan.hi].start == plan.lo)
+            ++plan.hi;
+    }
+    resume_locked(plan);
+    return true;
+}
+
+void dbg::resume_locked(const step_plan &plan)
+{
+    if (exec_running_)
+        return;
+    if (!exec_thread_.joinable())
+        exec_thread_ = std::thread(&dbg::execution_main, this);
+    plan_ = plan;
+    stop_request_.store(stop_request::none, std::memory_order_relaxed);
+    exec_running_ = true;
+    exec_cv_.notify_all();
+}
+
+bool dbg::request_pause()
+{
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    if (!exec_running_)
+        return false;
+    stop_request_.store(stop_request::pause, std::memory_order_relaxed);
+    return true;
+}
+
+bool dbg::stop_execution()
+{
+    std::unique_lock<std::mutex> lock(exec_mutex_);
+    if (!exec_running_)
+        return false;
+    stop_request_.store(stop_request::silent, std::memory_order_relaxed);
+    exec_cv_.wait(lock, [this] { return !exec_running_; });
+    return true;
+}
+
+bool dbg::park_execution()
+{
+    std::unique_lock<std::mutex> lock(exec_mutex_);
+    if (!exec_running_)
+        return false;
+    // A CAS, as the CPU loop may report a data breakpoint hit meanwhile;
+    // that stop wins and the wait ends with the thread stopped.
+    auto expected = stop_request::none;
+    stop_request_.compare_exchange_strong(expected, stop_request::park,
+                                          std::memory_order_relaxed);
+    exec_cv_.wait(lock, [this] { return exec_parked_ || !exec_running_; });
+    return exec_parked_;
+}
+
+void dbg::unpark_execution()
+{
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    auto expected = stop_request::park;
+    stop_request_.compare_exchange_strong(expected, stop_request::none,
+                                          std::memory_order_relaxed);
+    exec_cv_.notify_all();
+}
+
+bool dbg::running() const
+{
+    std::lock_guard<std::mutex> lock(exec_mutex_);
+    return exec_running_;
+}
+
+void dbg::execution_main()
+{
+    std::unique_lock<std::mutex> lock(exec_mutex_);
+    while (true)
+    {
+        exec_cv_.wait(lock, [this] { return exec_running_ || exec_quit_; });
+        if (exec_quit_)
+            return;
+
+        lock.unlock();
+        std::string description;
+        const char *reason = run_until_stop(description);
+        if (reason == data_breakpoint_reason)
+            description = data_hit_;
+        lock.lock();
+
+        exec_running_ = false;
+        exec_cv_.notify_all();
+
+        // Report outside the lock: the event may wait for the dispatcher
+        // to finish writing the response of the request being handled.
+        lock.unlock();
+        flush_console();
+        if (reason)
+            send_stopped_event(reason, description);
+        lock.lock();
+    }
+}
+
+// Execute one instruction, prefixes included, and keep the shadow call
+// stack in step. Returns true if the CPU then accepted an interrupt.
+bool dbg::step_instruction()
+{
+    const uint16_t start = z80ex_get_reg(cpu_, regPC);
+    uint16_t pc;
+    uint8_t op;
+    unsigned tstates = 0;
+    do
+    {
+        pc = z80ex_get_reg(cpu_, regPC);
+        op = memory_.read(pc);
+        auto t = static_cast<unsigned>(z80ex_step(cpu_));
+        scheduler_.advance(t);
+        tstates += t;
+    } while (z80ex_last_op_type(cpu_));
+    // One record per instruction, prefixes included, at its first byte.
+    if (instruments_)
+        instrument(start, tstates);
+    int call_len = call_length(op);
+    uint16_t sp = z80ex_get_reg(cpu_, regSP);
+
+    auto return_pc = static_cast<uint16_t>(pc + call_len);
+    if (call_len && z80ex_get_reg(cpu_, regPC) != return_pc)
+        push_call_frame(pc, return_pc, sp);
+    else
+    {
+        while (!call_stack_.empty() && sp_above(sp, call_stack_.back().sp))
+        {
+            call_stack_.pop_back();
+            if (instruments_ & instrument_calls)
+                call_graph_.leave();
+        }
+    }
+
+    if (scheduler_.due())
+        scheduler_.run_due();
+    bool interrupted = interrupts_.pending() && accept_interrupt();
+
+    ++steps_;
+    if (scheduler_.now() >= next_snapshot_)
+        take_snapshot(op);
+    return interrupted;
+}
+
+// Called by the memory callbacks for accesses to watched pages, during
+// the instruction. The first hit asks the CPU loop to stop once the
+// instruction is done; pause and stop requests from handlers take
+// precedence, while a pending park gives way (the parking handler then
+// finds the CPU stopped).
+void dbg::data_access(uint16_t addr, uint8_t access, uint8_t value)
+{
+    if (replaying_)
+        return;
+    uint32_t at = memory_.physical(addr);
+    for (const auto &bp : data_breakpoints_)
+    {
+        if (!(bp.access & access) || at < bp.address || at - bp.address >= bp.size)
+            continue;
+        auto expected = stop_request::none;
+        if (stop_request_.compare_exchange_strong(expected, stop_request::data,
+                                                  std::memory_order_relaxed) ||
+            (expected == stop_request::park &&
+             stop_request_.compare_exchange_strong(expected, stop_request::data,
+                                                   std::memory_order_relaxed)))
+        {
+            data_hit_ = access == memory_map::watch_write
+                ? "Write of " + format_hex(value, 2) + " to "
+                : "Read of " + format_hex(value, 2) + " from ";
+            data_hit_ += bp.name + " (" + format_hex(at, 4) + ")";
+        }
+        return;
+    }
+}
+
+// Instrumentation of the instruction at `pc` that just executed.
+void dbg::instrument(uint16_t pc, unsigned tstates)
+{
+    if (instruments_ & instrument_profile)
+        profile_.record(memory_.physical(pc), tstates);
+    if (instruments_ & instrument_calls)
+        call_graph_.record(tstates);
+    if (instruments_ & instrument_coverage)
+        coverage_.mark(memory_.physical(pc));
+}
+
+// The call graph follows the shadow call stack from here on; calls that
+// are active already are charged to its root until they return.
+void dbg::set_profiling(bool on, bool calls)
+{
+    const bool following = instruments_ & instrument_calls;
+    instruments_ &= static_cast<uint8_t>(~(instrument_profile | instrument_calls));
+    if (!on)
+        return;
+    profile_.resize(memory_.store().size());
+    instruments_ |= instrument_profile;
+    if (calls)
+    {
+        if (!following)
+            call_graph_.reset_path();
+        instruments_ |= instrument_calls;
+    }
+}
+
+void dbg::set_coverage(bool on)
+{
+    if (on)
+    {
+        coverage_.resize(memory_.store().size());
+        instruments_ |= instrument_coverage;
+    }
+    else
+        instruments_ &= static_cast<uint8_t>(~instrument_coverage);
+}
+
+void dbg::start_sampling(uint32_t interval, size_t capacity)
+{
+    sampler_.configure(interval, capacity);
+    if (!sample_timer_)
+        sample_timer_.emplace(scheduler_, [this](uint64_t at) { take_sample(at); });
+    sample_timer_->arm(scheduler_.now() + interval);
+}
+
+void dbg::stop_sampling()
+{
+    if (sample_timer_)
+        sample_timer_->cancel();
+}
+
+// Sampling timer: the instruction that ran over the due time has just
+// finished, so the PC is where the CPU is about to continue.
+void dbg::take_sample(uint64_t at)
+{
+    pc_sampler::sample s;
+    s.frames[0] = memory_.physical(z80ex_get_reg(cpu_, regPC));
+    s.depth = 1;
+    for (auto it = call_stack_.rbegin();
+         it != call_stack_.rend() && s.depth < pc_sampler::stack_depth; ++it)
+        s.frames[s.depth++] = it->call_pc;
+    // Replays for reverse execution run code that was sampled already.
+    if (!replaying_)
+        sampler_.record(s);
+    sample_timer_->arm(at + sampler_.interval());
+}
+
+// Called once the call or interrupt has been taken: the PC is the target.
+void dbg::push_call_frame(uint16_t call_pc, uint16_t return_pc, uint16_t sp)
+{
+    const bool calls = instruments_ & instrument_calls;
+    if (call_stack_.size() == max_call_depth)
+    {
+        if (calls && call_graph_.depth() == call_stack_.size())
+            call_graph_.drop_outermost();
+        call_stack_.erase(call_stack_.begin());
+    }
+    call_stack_.push_back({memory_.physical(call_pc), return_pc, sp});
+    if (calls)
+        call_graph_.enter(memory_.physical(z80ex_get_reg(cpu_, regPC)));
+}
+
+// Let the CPU take a pending NMI, or INT if it has interrupts enabled. An
+// accepted interrupt shows in stack traces as a call made by the
+// instruction it interrupted.
+bool dbg::accept_interrupt()
+{
+    uint16_t pc = z80ex_get_reg(cpu_, regPC);
+    int tstates = 0;
+    if (interrupts_.nmi_pending())
+    {
+        tstates = z80ex_nmi(cpu_);
+        if (tstates)
+            interrupts_.acknowledge_nmi();
+    }
+    else
+    {
+        // z80ex reads the vector through intread_cb in IM 0 and IM 2;
+        // in any mode the request has been served once it returns.
+        tstates = z80ex_int(cpu_);
+        if (tstates)
+            interrupts_.acknowledge();
+    }
+    if (!tstates)
+        return false;
+    scheduler_.advance(static_cast<unsigned>(tstates));
+
+    // The return address is on the stack: after a HALT it is pc + 1.
+    uint16_t sp = z80ex_get_reg(cpu_, regSP);
+    auto return_pc = static_cast<uint16_t>(
+        memory_.read(sp) | (memory_.read(static_cast<uint16_t>(sp + 1)) << 8));
+    push_call_frame(pc, return_pc, sp);
+    return true;
+}
+
+// Called by the CPU loops once per instruction. Parks in place while a
+// park is requested; returns the stop reason (nullptr for a silent stop)
+// when the loop has to end.
+std::optional<const char *> dbg::poll_stop()
+{
+    switch (stop_request_.load(std::memory_order_relaxed))
+    {
+    case stop_request::none:
+        return std::nullopt;
+    case stop_request::pause:
+        return "pause";
+    case stop_request::silent:
+        return nullptr;
+    case stop_request::data:
+        return data_breakpoint_reason;
+    case stop_request::park:
+        break;
+    }
+
+    std::unique_lock<std::mutex> lock(exec_mutex_);
+    exec_parked_ = true;
+    exec_cv_.notify_all();
+    exec_cv_.wait(lock, [this]
+        { return stop_request_.load(std::memory_order_relaxed) != stop_request::park; });
+    exec_parked_ = false;
+    return std::nullopt;
+}
+
+// Nothing can wake the CPU up again.
+bool dbg::halted_for_good(std::string &description)
+{
+    if (!z80ex_doing_halt(cpu_) || z80ex_get_reg(cpu_, regIFF1))
+        return false;
+    description = "HALT with interrupts disabled";
+    return true;
+}
+
+// Run until something stops the CPU. Returns the DAP stop reason, or
+// nullptr for a silent stop requested by stop_execution().
+const char *dbg::run_until_stop(std::string &description)
+{
+    if (plan_.mode == exec_mode::run)
+        return run_free(description);
+    if (plan_.mode == exec_mode::step_back ||
+        plan_.mode == exec_mode::reverse_continue)
+        return run_reverse(description);
+    return run_step(description);
+}
+
+const char *dbg::run_free(std::string &description)
+{
+    while (true)
+    {
+        if (auto stop = poll_stop())
+            return *stop;
+
+        // Step first so we don't re-trigger the breakpoint
+        // we're currently stopped at.
+        step_instruction();
+        uint16_t pc = z80ex_get_reg(cpu_, regPC);
+
+        if (bp_map_[pc] && breakpoint_hit(pc))
+            return "breakpoint";
+        if (halted_for_good(description))
+            return "pause";
+    }
+}
+
+const char *dbg::run_step(std::string &description)
+{
+    const bool over = plan_.mode != exec_mode::step_in;
+    while (true)
+    {
+        if (auto stop = poll_stop())
+            return *stop;
+
+        uint16_t pc = z80ex_get_reg(cpu_, regPC);
+        uint16_t sp = z80ex_get_reg(cpu_, regSP);
+        uint8_t op = memory_.read(pc);
+        int call_len = call_length(op);
+        bool ret = is_return(op, memory_.read(static_cast<uint16_t>(pc + 1)));
+
+        bool interrupted = step_instruction();
+        uint16_t npc = z80ex_get_reg(cpu_, regPC);
+        bool checked = false;   // run_to_return() tested npc for breakpoints.
+
+        // Source-level steps run interrupt handlers through, as if the
+        // instruction had taken a little longer.
+        if (interrupted && !plan_.instruction)
+        {
+            const auto frame = call_stack_.back();
+            auto stop = run_to_return(frame.return_pc,
+                                      static_cast<uint16_t>(frame.sp + 2),
+                                      description);
+            if (stop)
+                return *stop;
+            npc = frame.return_pc;
+            checked = true;
+        }
+
+        // Step over a taken call by running to its return address. Step in
+        // still steps over calls into code without line info.
+        if (call_len && npc != static_cast<uint16_t>(pc + call_len) &&
+            (over || !line_table_[memory_.physical(npc)].line))
+        {
+            auto stop = run_to_return(static_cast<uint16_t>(pc + call_len), sp,
+                                      description);
+            if (stop)
+                return *stop;
+            npc = static_cast<uint16_t>(pc + call_len);
+            checked = true;
+        }
+
+        // Test each arrival once: hit counts count every test.
+        if (!checked && (bp_map_[npc] & ~bp_temp) && breakpoint_hit(npc))
+            return "breakpoint";
+        if (halted_for_good(description))
+            return "pause";
+
+        if (plan_.mode == exec_mode::step_out)
+        {
+            // Done once a return pops the frame's return address, however
+            // much the function pushed or popped after the step began.
+            if (ret && sp_above(z80ex_get_reg(cpu_, regSP), plan_.frame_sp))
+                return "step";
+            continue;
+        }
+
+        if (plan_.instruction)
+            return "step";
+
+        // Still inside the line being stepped (re-entering its first
+        // address counts as a new execution of the line).
+        uint32_t at = memory_.physical(npc);
+        if (at > plan_.lo && at < plan_.hi)
+            continue;
+
+        // Stop at the start of a line, or on code without line info.
+        const auto &entry = line_table_[at];
+        if (!entry.line || entry.start == at)
+            return "step";
+    }
+}
+
+// Free-run with a temporary breakpoint on `return_pc` until the call made
+// with stack pointer `sp` returns there (recursive calls hitting the same
+// address deeper in the stack are ignored). Returns std::nullopt once
+// returned, or the stop reason if something else stopped the CPU.
+std::optional<const char *> dbg::run_to_return(uint16_t return_pc,
+                                               uint16_t sp,
+                                               std::string &description)
+{
+    bp_map_[return_pc] |= bp_temp;
+
+    std::optional<const char *> result;
+    while (true)
+    {
+        if (auto stop = poll_stop())
+        {
+            result = *stop;
+            break;
+        }
+
+        step_instruction();
+        uint16_t pc = z80ex_get_reg(cpu_, regPC);
+
+        uint8_t flags = bp_map_[pc];
+        if (flags)
+        {
+            if ((flags & ~bp_temp) && breakpoint_hit(pc))
+            {
+                result = "breakpoint";
+                break;
+            }
+            if ((flags & bp_temp) && !sp_above(sp, z80ex_get_reg(cpu_, regSP)))
+                break;
+        }
+        if (halted_for_good(description))
+        {
+            result = "pause";
+            break;
+        }
+    }
+
+    bp_map_[return_pc] &= static_cast<uint8_t>(~bp_temp);
+    return result;
+}
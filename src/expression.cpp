@@ -0,0 +1,506 @@
+// expression.cpp
+// Breakpoint conditions compiled to bytecode.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <expression.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+namespace {
+
+using op = expression::op;
+
+struct register_name {
+    const char *name;
+    Z80_REG_T reg;
+    op part;    // reg (16 bits), reg_high or reg_low.
+};
+
+constexpr register_name registers[] = {
+    {"A", regAF, op::reg_high},   {"F", regAF, op::reg_low},
+    {"B", regBC, op::reg_high},   {"C", regBC, op::reg_low},
+    {"D", regDE, op::reg_high},   {"E", regDE, op::reg_low},
+    {"H", regHL, op::reg_high},   {"L", regHL, op::reg_low},
+    {"IXH", regIX, op::reg_high}, {"IXL", regIX, op::reg_low},
+    {"IYH", regIY, op::reg_high}, {"IYL", regIY, op::reg_low},
+    {"I", regI, op::reg},         {"R", regR, op::reg},
+    {"AF", regAF, op::reg},       {"BC", regBC, op::reg},
+    {"DE", regDE, op::reg},       {"HL", regHL, op::reg},
+    {"IX", regIX, op::reg},       {"IY", regIY, op::reg},
+    {"SP", regSP, op::reg},       {"PC", regPC, op::reg},
+    {"AF'", regAF_, op::reg},     {"BC'", regBC_, op::reg},
+    {"DE'", regDE_, op::reg},     {"HL'", regHL_, op::reg},
+};
+
+struct type_name {
+    const char *name;
+    op conversion;
+};
+
+constexpr type_name types[] = {
+    {"byte", op::zext8},      {"uint8_t", op::zext8},    {"unsigned char", op::zext8},
+    {"char", op::zext8},      {"int8_t", op::sext8},     {"signed char", op::sext8},
+    {"word", op::zext16},     {"uint16_t", op::zext16},  {"unsigned int", op::zext16},
+    {"unsigned", op::zext16}, {"unsigned short", op::zext16},
+    {"int", op::sext16},      {"int16_t", op::sext16},   {"short", op::sext16},
+    {"signed int", op::sext16}, {"signed short", op::sext16},
+};
+
+// Binary operators by precedence level, loosest first.
+struct binary_operator {
+    const char *text;
+    op code;
+};
+
+const std::vector<std::vector<binary_operator>> levels = {
+    {{"||", op::lor}},
+    {{"&&", op::land}},
+    {{"|", op::bor}},
+    {{"^", op::bxor}},
+    {{"&", op::band}},
+    {{"==", op::eq}, {"!=", op::ne}},
+    {{"<=", op::le}, {">=", op::ge}, {"<", op::lt}, {">", op::gt}},
+    {{"<<", op::shl}, {">>", op::shr}},
+    {{"+", op::add}, {"-", op::sub}},
+    {{"*", op::mul}, {"/", op::div}, {"%", op::mod}},
+};
+
+bool ident_start(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+bool ident_char(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+bool iequals(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+               { return std::toupper(static_cast<unsigned char>(x)) ==
+                        std::toupper(static_cast<unsigned char>(y)); });
+}
+
+} // namespace
+
+// Recursive descent over the text, emitting code as it goes.
+class expression_compiler
+{
+public:
+    expression_compiler(std::string_view text, const expression::resolver &resolve)
+        : text_(text), resolve_(resolve) {}
+
+    std::optional<expression> run(std::string &error)
+    {
+        binary(0);
+        skip_space();
+        if (error_.empty() && pos_ < text_.size())
+            fail("Unexpected '" + std::string(text_.substr(pos_, 1)) + "'");
+        if (!error_.empty())
+        {
+            error = error_;
+            return std::nullopt;
+        }
+        return std::move(result_);
+    }
+
+private:
+    void fail(const std::string &message)
+    {
+        if (error_.empty())
+            error_ = message + " at column " + std::to_string(pos_ + 1);
+    }
+
+    void skip_space()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+            ++pos_;
+    }
+
+    bool accept(std::string_view token)
+    {
+        skip_space();
+        if (text_.substr(pos_, token.size()) != token)
+            return false;
+        // "<" isn't "<<" or "<=", "|" isn't "||", and so on.
+        if (token.size() == 1 && pos_ + 1 < text_.size())
+        {
+            char next = text_[pos_ + 1];
+            if ((token == "<" && (next == '<' || next == '=')) ||
+                (token == ">" && (next == '>' || next == '=')) ||
+                (token == "&" && next == '&') || (token == "|" && next == '|') ||
+                (token == "!" && next == '='))
+                return false;
+        }
+        pos_ += token.size();
+        return true;
+    }
+
+    void expect(std::string_view token)
+    {
+        if (!accept(token))
+            fail("Expected '" + std::string(token) + "'");
+    }
+
+    std::string identifier()
+    {
+        skip_space();
+        size_t start = pos_;
+        if (pos_ < text_.size() && ident_start(text_[pos_]))
+        {
+            ++pos_;
+            while (pos_ < text_.size() && ident_char(text_[pos_]))
+                ++pos_;
+        }
+        return std::string(text_.substr(start, pos_ - start));
+    }
+
+    void emit(op code, int32_t operand, int depth)
+    {
+        result_.code_.push_back({code, operand});
+        depth_ += depth;
+        if (depth_ > static_cast<int>(expression::max_depth))
+            fail("Condition is too complex");
+    }
+
+    void binary(size_t level)
+    {
+        if (level == levels.size())
+        {
+            unary();
+            return;
+        }
+        binary(level + 1);
+        while (error_.empty())
+        {
+            const binary_operator *found = nullptr;
+            for (const auto &candidate : levels[level])
+            {
+                if (accept(candidate.text))
+                {
+                    found = &candidate;
+                    break;
+                }
+            }
+            if (!found)
+                return;
+            binary(level + 1);
+            emit(found->code, 0, -1);
+        }
+    }
+
+    void unary()
+    {
+        // Bounds the recursion, whatever the stack depth of the code.
+        if (++nesting_ > max_nesting)
+            fail("Condition is too complex");
+        if (error_.empty())
+            unary_operand();
+        --nesting_;
+    }
+
+    void unary_operand()
+    {
+        if (accept("!"))
+        {
+            unary();
+            emit(op::lnot, 0, 0);
+        }
+        else if (accept("~"))
+        {
+            unary();
+            emit(op::bnot, 0, 0);
+        }
+        else if (accept("-"))
+        {
+            unary();
+            emit(op::neg, 0, 0);
+        }
+        else if (accept("+"))
+            unary();
+        else if (auto conversion = cast())
+        {
+            unary();
+            if (!error_.empty())
+                return;
+            // A cast of [address] sets the width of the read.
+            auto &last = result_.code_.back();
+            if (last.code == op::load8 &&
+                (*conversion == op::zext16 || *conversion == op::sext16))
+                last.code = op::load16;
+            emit(*conversion, 0, 0);
+        }
+        else
+            primary();
+    }
+
+    // "(type)", or nullopt (consuming nothing) if there isn't one.
+    std::optional<op> cast()
+    {
+        size_t start = pos_;
+        if (!accept("("))
+            return std::nullopt;
+        std::string name = identifier();
+        if (name == "signed" || name == "unsigned")
+        {
+            size_t after = pos_;
+            std::string next = identifier();
+            if (next.empty())
+                pos_ = after;
+            else
+                name += " " + next;
+        }
+        for (const auto &t : types)
+        {
+            if (name == t.name && accept(")"))
+                return t.conversion;
+        }
+        pos_ = start;
+        return std::nullopt;
+    }
+
+    void primary()
+    {
+        skip_space();
+        if (pos_ >= text_.size())
+        {
+            fail("Unexpected end of condition");
+            return;
+        }
+        if (accept("("))
+        {
+            binary(0);
+            expect(")");
+            return;
+        }
+        if (accept("["))
+        {
+            binary(0);
+            expect("]");
+            emit(op::load8, 0, 0);
+            return;
+        }
+
+        char c = text_[pos_];
+        if (std::isdigit(static_cast<unsigned char>(c)) ||
+            (c == '$' && pos_ + 1 < text_.size() &&
+             std::isxdigit(static_cast<unsigned char>(text_[pos_ + 1]))))
+        {
+            number();
+            return;
+        }
+
+        std::string name = identifier();
+        if (name.empty())
+        {
+            fail("Unexpected '" + std::string(1, c) + "'");
+            return;
+        }
+        // The quote of AF' and friends isn't part of the identifier.
+        if (pos_ < text_.size() && text_[pos_] == '\'')
+        {
+            for (const auto &r : registers)
+            {
+                if (iequals(name + "'", r.name))
+                {
+                    ++pos_;
+                    emit(r.part, r.reg, 1);
+                    return;
+                }
+            }
+        }
+        for (const auto &r : registers)
+        {
+            if (iequals(name, r.name))
+            {
+                emit(r.part, r.reg, 1);
+                return;
+            }
+        }
+        if (auto address = resolve_ ? resolve_(name) : std::nullopt)
+            emit(op::constant, static_cast<int32_t>(*address), 1);
+        else
+            fail("Unknown symbol '" + name + "'");
+    }
+
+    void number()
+    {
+        int base = 10;
+        if (text_[pos_] == '$')
+        {
+            base = 16;
+            ++pos_;
+        }
+        else if (text_.substr(pos_, 2) == "0x" || text_.substr(pos_, 2) == "0X")
+        {
+            base = 16;
+            pos_ += 2;
+        }
+        uint64_t value = 0;
+        size_t start = pos_;
+        while (pos_ < text_.size() && std::isxdigit(static_cast<unsigned char>(text_[pos_])))
+        {
+            char c = static_cast<char>(std::tolower(static_cast<unsigned char>(text_[pos_])));
+            int digit = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : c - 'a' + 10;
+            if (digit >= base)
+                break;
+            value = value * base + digit;
+            if (value > UINT32_MAX)
+            {
+                fail("Number is too large");
+                return;
+            }
+            ++pos_;
+        }
+        if (pos_ == start || (pos_ < text_.size() && ident_char(text_[pos_])))
+        {
+            fail("Malformed number");
+            return;
+        }
+        emit(op::constant, static_cast<int32_t>(value), 1);
+    }
+
+    static constexpr int max_nesting = 256;
+
+    std::string_view text_;
+    const expression::resolver &resolve_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+    int nesting_ = 0;
+    std::string error_;
+    expression result_;
+};
+
+std::optional<expression> expression::compile(std::string_view text,
+                                              const resolver &resolve,
+                                              std::string &error)
+{
+    return expression_compiler(text, resolve).run(error);
+}
+
+int32_t expression::evaluate(Z80EX_CONTEXT *cpu, const memory_map &memory) const
+{
+    // Unsigned arithmetic wraps where signed would overflow.
+    std::array<uint32_t, max_depth> stack;
+    size_t top = 0;
+    for (const auto &in : code_)
+    {
+        uint32_t &a = stack[top ? top - 1 : 0];
+        switch (in.code)
+        {
+        case op::constant:
+            stack[top++] = static_cast<uint32_t>(in.operand);
+            continue;
+        case op::reg:
+            stack[top++] = z80ex_get_reg(cpu, static_cast<Z80_REG_T>(in.operand));
+            continue;
+        case op::reg_high:
+            stack[top++] = z80ex_get_reg(cpu, static_cast<Z80_REG_T>(in.operand)) >> 8;
+            continue;
+        case op::reg_low:
+            stack[top++] = z80ex_get_reg(cpu, static_cast<Z80_REG_T>(in.operand)) & 0xFF;
+            continue;
+        case op::load8:
+            a = memory.read(static_cast<uint16_t>(a));
+            continue;
+        case op::load16:
+            a = memory.read(static_cast<uint16_t>(a)) |
+                (memory.read(static_cast<uint16_t>(a + 1)) << 8);
+            continue;
+        case op::zext8: a &= 0xFF; continue;
+        case op::zext16: a &= 0xFFFF; continue;
+        case op::sext8: a = static_cast<uint32_t>(static_cast<int8_t>(a)); continue;
+        case op::sext16: a = static_cast<uint32_t>(static_cast<int16_t>(a)); continue;
+        case op::neg: a = 0u - a; continue;
+        case op::lnot: a = !a; continue;
+        case op::bnot: a = ~a; continue;
+        default:
+            break;
+        }
+
+        // Binary: b is the right operand, the result replaces a.
+        uint32_t b = stack[--top];
+        uint32_t &l = stack[top - 1];
+        auto sl = static_cast<int32_t>(l);
+        auto sb = static_cast<int32_t>(b);
+        switch (in.code)
+        {
+        case op::mul: l = l * b; break;
+        case op::div: l = b && !(sl == INT32_MIN && sb == -1) ? static_cast<uint32_t>(sl / sb) : 0; break;
+        case op::mod: l = b && !(sl == INT32_MIN && sb == -1) ? static_cast<uint32_t>(sl % sb) : 0; break;
+        case op::add: l = l + b; break;
+        case op::sub: l = l - b; break;
+        case op::shl: l = l << (b & 31); break;
+        case op::shr: l = static_cast<uint32_t>(sl >> (b & 31)); break;
+        case op::lt: l = sl < sb; break;
+        case op::le: l = sl <= sb; break;
+        case op::gt: l = sl > sb; break;
+        case op::ge: l = sl >= sb; break;
+        case op::eq: l = l == b; break;
+        case op::ne: l = l != b; break;
+        case op::band: l = l & b; break;
+        case op::bxor: l = l ^ b; break;
+        case op::bor: l = l | b; break;
+        case op::land: l = l && b; break;
+        case op::lor: l = l || b; break;
+        default: break;
+        }
+    }
+    return top ? static_cast<int32_t>(stack[top - 1]) : 0;
+}
+
+std::optional<hit_condition> hit_condition::parse(std::string_view text)
+{
+    auto trim = [](std::string_view s)
+    {
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+            s.remove_prefix(1);
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+            s.remove_suffix(1);
+        return s;
+    };
+    text = trim(text);
+
+    hit_condition result;
+    static constexpr std::pair<std::string_view, kind> prefixes[] = {
+        {">=", kind::ge}, {"<=", kind::le}, {"==", kind::eq}, {"=", kind::eq},
+        {">", kind::gt},  {"<", kind::lt},  {"%", kind::every},
+    };
+    for (const auto &[prefix, k] : prefixes)
+    {
+        if (text.starts_with(prefix))
+        {
+            result.kind_ = k;
+            text = trim(text.substr(prefix.size()));
+            break;
+        }
+    }
+    if (text.empty() || text.size() > 18 ||
+        !std::all_of(text.begin(), text.end(),
+                     [](char c) { return std::isdigit(static_cast<unsigned char>(c)); }))
+        return std::nullopt;
+    for (char c : text)
+        result.count_ = result.count_ * 10 + static_cast<uint64_t>(c - '0');
+    if (result.kind_ == kind::every && !result.count_)
+        return std::nullopt;
+    return result;
+}
+
+bool hit_condition::test(uint64_t hits) const
+{
+    switch (kind_)
+    {
+    case kind::ge: return hits >= count_;
+    case kind::eq: return hits == count_;
+    case kind::gt: return hits > count_;
+    case kind::lt: return hits < count_;
+    case kind::le: return hits <= count_;
+    case kind::every: return hits % count_ == 0;
+    }
+    return false;
+}
@@ -0,0 +1,79 @@
+// expression.h
+// Breakpoint conditions compiled to bytecode.
+//
+// A condition such as `HL == 0x4000 && (byte)[_frame] > 3` is parsed
+// once, when the breakpoint is set, into a short program for a stack
+// machine: registers and memory are read when it runs, symbols are
+// resolved to their addresses while compiling. Evaluating it walks the
+// program over a fixed size stack, so a conditional breakpoint in a tight
+// loop costs neither parsing nor allocation per hit.
+//
+// The language is C expressions over 32-bit integers:
+//   numbers      1234, 0x4000, $4000
+//   registers    A F B C D E H L I R IXH IXL IYH IYL
+//                AF BC DE HL IX IY SP PC AF' BC' DE' HL' (any case)
+//   symbols      global variables and MAP labels stand for their address
+//   memory       [address] reads a byte
+//   casts        (byte) (word) (char) (int) (uint8_t) (int16_t) ...;
+//                applied to [address] they set the width of the read
+//   operators    ! ~ - + * / % << >> < <= > >= == != & ^ | && ||
+// Division by zero gives 0.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <z80ex.h>
+#include <memory_map.h>
+
+class expression
+{
+public:
+    static constexpr size_t max_depth = 32;
+
+    // Address of a name that isn't a register, or nullopt if unknown.
+    using resolver = std::function<std::optional<uint32_t>(const std::string &)>;
+
+    // nullopt, with `error` set, if `text` doesn't compile.
+    static std::optional<expression> compile(std::string_view text,
+                                             const resolver &resolve,
+                                             std::string &error);
+
+    int32_t evaluate(Z80EX_CONTEXT *cpu, const memory_map &memory) const;
+
+    enum class op : uint8_t {
+        constant, reg, reg_high, reg_low, load8, load16,
+        zext8, zext16, sext8, sext16,
+        neg, lnot, bnot,
+        mul, div, mod, add, sub, shl, shr,
+        lt, le, gt, ge, eq, ne, band, bxor, bor, land, lor,
+    };
+    struct instruction {
+        op code;
+        int32_t operand = 0;    // Constant, or register (Z80_REG_T).
+    };
+
+private:
+    friend class expression_compiler;
+    std::vector<instruction> code_;
+};
+
+// DAP hit condition: "5" or ">=5" (from the fifth hit on), "==5" or "=5"
+// (the fifth only), ">5", "<5", "<=5", or "%5" (every fifth).
+class hit_condition
+{
+public:
+    static std::optional<hit_condition> parse(std::string_view text);
+    bool test(uint64_t hits) const;
+
+private:
+    enum class kind : uint8_t { ge, eq, gt, lt, le, every };
+    kind kind_ = kind::ge;
+    uint64_t count_ = 0;
+};
@@ -0,0 +1,54 @@
+// console_input.cpp — custom "consoleInput" request handler.
+//
+// Types text into the console device: the program reads it from the SIO
+// data port a byte at a time, with RR0 reporting a character available
+// until the queue is empty. Arguments:
+//   text:      the bytes to queue, sent as is (terminals send "\r" for
+//              Enter, which CP/M programs expect)
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class console_input_handler : public dap::request_handler {
+public:
+    console_input_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "consoleInput"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        const auto &args = req.arguments;
+        dap::response resp(req.seq, req.command);
+        if (!args.is_object() || !args.contains("text") || !args["text"].is_string())
+        {
+            resp.success(false).message("consoleInput needs a text argument");
+            return resp.str();
+        }
+
+        // The CPU loop reads the queue, so park it while adding to it.
+        execution_pause guard(ctx_);
+        if (!ctx_.console())
+        {
+            resp.success(false).message("The machine has no console device");
+            return resp.str();
+        }
+        ctx_.console()->receive(args["text"].get<std::string>());
+        // Replays can't type the text again: history starts over here.
+        ctx_.restart_recording();
+        return resp.success(true).result({}).str();
+    }
+
+private:
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_console_input(dbg &ctx)
+{
+    return std::make_unique<console_input_handler>(ctx);
+}
+
+} // namespace handlers
@@ -0,0 +1,87 @@
+// data_breakpoint_info.cpp — DAP "dataBreakpointInfo" request handler.
+//
+// Resolves what the client wants to watch: a global variable by C name or
+// MAP label (typed in, or from the Symbols view), or an address such as
+// "0x8004", or "0x8004:2" for two bytes. The data id carries the physical
+// address, size and name on to setDataBreakpoints as
+// "<address>/<size>/<name>".
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class data_breakpoint_info_handler : public dap::request_handler {
+public:
+    data_breakpoint_info_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "dataBreakpointInfo"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        auto r = dap::data_breakpoint_info_request::from(req);
+        dap::response resp(r.seq, r.command);
+
+        auto var = resolve(r.name);
+        // Registers and segments have no address to watch.
+        if (r.variables_reference == 101 || r.variables_reference == 201 || !var)
+        {
+            resp.success(true).result({
+                {"dataId", nullptr},
+                {"description", "'" + r.name + "' has no address in memory"}});
+            return resp.str();
+        }
+
+        std::ostringstream id;
+        id << std::hex << var->address << '/' << std::dec << var->size << '/' << var->name;
+        std::string description = var->name + " (" + std::to_string(var->size) +
+                                  (var->size == 1 ? " byte at " : " bytes at ") +
+                                  ctx_.format_hex(var->address, 4) + ")";
+        resp.success(true).result({
+            {"dataId", id.str()},
+            {"description", description},
+            {"accessTypes", {"read", "write", "readWrite"}},
+            {"canPersist", true}});
+        return resp.str();
+    }
+
+private:
+    std::optional<variable_info> resolve(const std::string &name) const
+    {
+        if (auto var = ctx_.lookup_variable(name))
+            return var;
+
+        // Address, optionally followed by ":size".
+        try
+        {
+            size_t end = 0;
+            unsigned long address = std::stoul(name, &end, 0);
+            unsigned long size = 1;
+            if (end < name.size() && name[end] == ':')
+            {
+                size_t size_end = 0;
+                size = std::stoul(name.substr(end + 1), &size_end, 0);
+                end += 1 + size_end;
+            }
+            if (end != name.size() || !size || size > 0xFFFF || address > 0xFFFFFF)
+                return std::nullopt;
+            return variable_info{name, static_cast<uint32_t>(address),
+                                 static_cast<uint16_t>(size)};
+        }
+        catch (...)
+        {
+            return std::nullopt;
+        }
+    }
+
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_data_breakpoint_info(dbg &ctx)
+{
+    return std::make_unique<data_breakpoint_info_handler>(ctx);
+}
+
+} // namespace handlers
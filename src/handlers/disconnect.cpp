@@ -15,6 +15,9 @@ public:
 
     std::string handle(const dap::request &req) override
     {
+        ctx_.stop_execution();
+        if (ctx_.covering())
+            write_coverage();
         ctx_.set_launched(false);
 
         dap::response resp(req.seq, req.command);
@@ -22,6 +25,31 @@ public:
     }
 
 private:
+    // Write the lcov tracefile and show the per-function summary in the
+    // debug console.
+    void write_coverage()
+    {
+        ctx_.set_coverage(false);
+        auto report = summarize_coverage(ctx_, ctx_.coverage());
+        const auto &path = ctx_.coverage_path();
+        std::string text = coverage_text(report);
+
+        std::ofstream out(path, std::ios::binary);
+        out << coverage_lcov(report, "mudap");
+        if (out)
+            text += "Coverage written to " + path + "\n";
+        else
+            text += "Cannot write coverage to " + path + "\n";
+        std::cerr << "[disconnect] " << text;
+
+        nlohmann::json j;
+        j["seq"] = ctx_.next_event_seq();
+        j["type"] = "event";
+        j["event"] = "output";
+        j["body"] = {{"category", "console"}, {"output", text}};
+        ctx_.send_event(j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+    }
+
     dbg &ctx_;
 };
 
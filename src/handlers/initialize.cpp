@@ -31,9 +31,13 @@ public:
             .success(true)
             .result({{"supportsConfigurationDoneRequest", true},
                      {"supportsBreakpointLocationsRequest", true},
+                     {"supportsConditionalBreakpoints", true},
+                     {"supportsHitConditionalBreakpoints", true},
                      {"supportsInstructionBreakpoints", true},
+                     {"supportsDataBreakpoints", true},
                      {"supportsLoadedSourcesRequest", true},
-                     {"supportsStepBack", false},
+                     {"supportsStepBack", true},
+                     {"supportsRestartRequest", true},
                      {"supportsRestartFrame", false},
                      {"supportsEvaluateForHovers", false},
                      {"supportsSetVariable", false},
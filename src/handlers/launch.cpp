@@ -6,32 +6,41 @@
 #include <dap/handler.h>
 #include <sdcc/cdb_parser.h>
 #include <sdcc/map_parser.h>
+#include <sdcc/debug_cache.h>
+#include <platform/ctc.h>
+#include <platform/platform.h>
+#include <platform/sio.h>
 #include <dbg.h>
 
+#include <array>
+#include <future>
+
 namespace {
 
 struct ihx_load_result {
     uint16_t entry = 0;
     bool explicit_start = false;
+
+    // Bad records (first max_diagnostics described) that were skipped.
+    static constexpr size_t max_diagnostics = 10;
+    std::vector<std::string> diagnostics;
+    size_t errors = 0;
 };
 
-std::optional<uint16_t> parse_start_address_arg(const nlohmann::json &args)
+// A number, or a string like "0x1234".
+std::optional<uint32_t> parse_number_arg(const nlohmann::json &value)
 {
-    if (!args.contains("startAddress"))
-        return std::nullopt;
-
-    const auto &value = args["startAddress"];
     try
     {
         if (value.is_number_integer() || value.is_number_unsigned())
-            return static_cast<uint16_t>(value.get<uint32_t>() & 0xFFFF);
+            return value.get<uint32_t>();
 
         if (value.is_string())
         {
             const auto s = value.get<std::string>();
             if (s.empty())
                 return std::nullopt;
-            return static_cast<uint16_t>(std::stoul(s, nullptr, 0) & 0xFFFF);
+            return static_cast<uint32_t>(std::stoul(s, nullptr, 0));
         }
     }
     catch (...) {}
@@ -39,47 +48,272 @@ std::optional<uint16_t> parse_start_address_arg(const nlohmann::json &args)
     return std::nullopt;
 }
 
-// Parse an Intel HEX (.ihx/.hex) stream into a flat memory buffer.
+std::optional<uint16_t> parse_start_address_arg(const nlohmann::json &args)
+{
+    if (!args.contains("startAddress"))
+        return std::nullopt;
+
+    auto value = parse_number_arg(args["startAddress"]);
+    if (!value)
+        return std::nullopt;
+    return static_cast<uint16_t>(*value & 0xFFFF);
+}
+
+// Page aligned { "address", "size" } object within 64K.
+std::optional<platform::memory_range> parse_range_arg(const nlohmann::json &range,
+                                                      const char *what)
+{
+    auto address = range.is_object() && range.contains("address")
+        ? parse_number_arg(range["address"]) : std::nullopt;
+    auto size = range.is_object() && range.contains("size")
+        ? parse_number_arg(range["size"]) : std::nullopt;
+    if (!address || !size || *address + *size > 0x10000 ||
+        (*address & memory_map::page_mask) || (*size & memory_map::page_mask))
+    {
+        std::cerr << "[launch] WARNING: Ignoring " << what << ": needs an address "
+                  << "and size in multiples of 0x" << std::hex << memory_map::page_size
+                  << std::dec << " within 64K" << std::endl;
+        return std::nullopt;
+    }
+    return platform::memory_range{static_cast<uint16_t>(*address), *size};
+}
+
+// The machine to run on: the profile named by the "platform" launch
+// argument ("none" if absent), with its memory layout replaced by the
+// "memory" argument:
+//   { "banks": 8,
+//     "rom": { "address": "0x0000", "size": "0x4000" },
+//     "windows": [ { "address": "0xC000", "size": "0x4000", "port": "0x50" } ] }
+// and its devices by the "devices" argument:
+//   [ { "type": "sio", "port": "0x80" }, { "type": "ctc", "port": "0x88" } ]
+// "sio" is the console (data and control port), "ctc" a Z80 CTC (four
+// ports). The port is the first of the device's range.
+platform::profile select_profile(const nlohmann::json &args)
+{
+    const platform::profile *base = &platform::none::machine();
+    if (args.contains("platform") && args["platform"].is_string())
+    {
+        auto name = args["platform"].get<std::string>();
+        if (auto *p = platform::find_profile(name))
+            base = p;
+        else
+            std::cerr << "[launch] WARNING: Unknown platform '" << name
+                      << "', using '" << base->name << "'" << std::endl;
+    }
+    platform::profile machine = *base;
+
+    if (args.contains("memory") && args["memory"].is_object())
+    {
+        const auto &cfg = args["memory"];
+        auto banks = cfg.contains("banks") ? parse_number_arg(cfg["banks"]) : std::nullopt;
+        machine.banks = banks ? *banks : 1;
+        machine.rom = cfg.contains("rom")
+            ? parse_range_arg(cfg["rom"], "memory.rom") : std::nullopt;
+        machine.windows.clear();
+        if (cfg.contains("windows") && cfg["windows"].is_array())
+        {
+            for (const auto &item : cfg["windows"])
+            {
+                auto range = parse_range_arg(item, "memory.windows entry");
+                auto port = item.is_object() && item.contains("port")
+                    ? parse_number_arg(item["port"]) : std::nullopt;
+                if (!range)
+                    continue;
+                if (!port || *port > 0xFF)
+                {
+                    std::cerr << "[launch] WARNING: Ignoring memory.windows entry: "
+                              << "needs a port 0x00-0xFF" << std::endl;
+                    continue;
+                }
+                machine.windows.push_back({*range, static_cast<uint8_t>(*port)});
+            }
+        }
+    }
+
+    if (args.contains("devices") && args["devices"].is_array())
+    {
+        machine.devices.clear();
+        for (const auto &item : args["devices"])
+        {
+            auto type = item.is_object() && item.contains("type") && item["type"].is_string()
+                ? platform::find_device_type(item["type"].get<std::string>()) : std::nullopt;
+            auto port = item.is_object() && item.contains("port")
+                ? parse_number_arg(item["port"]) : std::nullopt;
+            if (!type || !port || *port > 0xFF)
+            {
+                std::cerr << "[launch] WARNING: Ignoring device " << item.dump()
+                          << ": unknown type or bad port" << std::endl;
+                continue;
+            }
+            machine.devices.push_back({*type, static_cast<uint8_t>(*port)});
+        }
+    }
+    return machine;
+}
+
+// Build the memory map and I/O bus for `machine`. The I/O bus must be
+// empty. After this the CPU loop only sees the page and port tables.
+void apply_profile(const platform::profile &machine, dbg &ctx)
+{
+    auto &mem = ctx.memory();
+    mem.configure(machine.banks);
+    if (machine.rom)
+        mem.set_rom(machine.rom->address >> memory_map::page_bits,
+                    machine.rom->size >> memory_map::page_bits);
+
+    for (const auto &window : machine.windows)
+    {
+        int index = mem.add_window(window.range.address >> memory_map::page_bits,
+                                   window.range.size >> memory_map::page_bits);
+        if (index < 0 ||
+            !ctx.attach_device(window.port, 1,
+                               std::make_unique<bank_register>(mem, index)))
+            std::cerr << "[launch] WARNING: Ignoring bank window at 0x" << std::hex
+                      << window.range.address << std::dec
+                      << ": overlaps another window or port" << std::endl;
+    }
+
+    for (const auto &item : machine.devices)
+    {
+        std::unique_ptr<platform::io_device> device;
+        platform::sio *console = nullptr;
+        unsigned count = 0;
+        switch (item.type)
+        {
+        case platform::device_type::sio:
+            device = std::make_unique<platform::sio>(
+                [&ctx](uint8_t c) { ctx.console_output(c); });
+            console = static_cast<platform::sio *>(device.get());
+            count = platform::sio::port_count;
+            break;
+        case platform::device_type::ctc:
+            device = std::make_unique<platform::ctc>(ctx.scheduler(), ctx.interrupts());
+            count = platform::ctc::port_count;
+            break;
+        }
+
+        auto name = platform::device_name(item.type);
+        if (!ctx.attach_device(item.port, count, std::move(device)))
+        {
+            std::cerr << "[launch] WARNING: Ignoring device " << name << " at port 0x"
+                      << std::hex << std::uppercase << unsigned(item.port) << std::dec
+                      << std::nouppercase << ": ports already taken" << std::endl;
+            continue;
+        }
+        if (console && !ctx.console())
+            ctx.set_console(console);
+        std::cerr << "[launch] Device: " << name << " at port 0x" << std::hex
+                  << std::uppercase << unsigned(item.port) << std::dec
+                  << std::nouppercase << std::endl;
+    }
+
+    ctx.scheduler().set_frequency(machine.clock_hz);
+    std::cerr << "[launch] Platform: " << machine.name << " (" << machine.description
+              << "), " << machine.clock_hz / 1000 << " kHz, " << mem.banks()
+              << " x 64K, " << mem.windows().size() << " bank windows" << std::endl;
+}
+
+// Hex digit values indexed by character, 0xFF for non-hex characters.
+constexpr std::array<uint8_t, 256> hex_digits = []
+{
+    std::array<uint8_t, 256> table{};
+    table.fill(0xFF);
+    for (int i = 0; i < 10; ++i)
+        table['0' + i] = static_cast<uint8_t>(i);
+    for (int i = 0; i < 6; ++i)
+    {
+        table['A' + i] = static_cast<uint8_t>(10 + i);
+        table['a' + i] = static_cast<uint8_t>(10 + i);
+    }
+    return table;
+}();
+
+// Decode hex digit pairs into out. Returns the number of bytes decoded,
+// or -1 if a character isn't a hex digit.
+int decode_hex(std::string_view text, uint8_t *out)
+{
+    size_t count = text.size() / 2;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t hi = hex_digits[static_cast<uint8_t>(text[2 * i])];
+        uint8_t lo = hex_digits[static_cast<uint8_t>(text[2 * i + 1])];
+        if ((hi | lo) & 0xF0)
+            return -1;
+        out[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return static_cast<int>(count);
+}
+
+// Parse an Intel HEX (.ihx/.hex) stream into physical memory; extended
+// address records select the bank (see memory_map.h).
 // Prefers explicit start address records (types 03/05); otherwise falls back
-// to the lowest data address.
+// to the lowest data address. Each record is decoded in place and must
+// pass its checksum; records that don't are skipped and reported, as is
+// data beyond the physical memory.
 ihx_load_result load_ihx(std::istream &in, std::vector<uint8_t> &mem)
 {
+    ihx_load_result result;
     uint32_t upper_base = 0;
     uint32_t lowest_data_addr = 0xFFFFFFFF;
     std::optional<uint32_t> explicit_entry;
 
+    auto report = [&](size_t line_no, const std::string &message)
+    {
+        if (result.diagnostics.size() < ihx_load_result::max_diagnostics)
+            result.diagnostics.push_back("line " + std::to_string(line_no) + ": " + message);
+        ++result.errors;
+    };
+
+    // Byte count, address (2), type, up to 255 data bytes and checksum.
+    std::array<uint8_t, 5 + 255> rec;
     std::string line;
+    size_t line_no = 0;
     while (std::getline(in, line))
     {
-        if (line.empty() || line[0] != ':')
+        ++line_no;
+        std::string_view text(line);
+        while (!text.empty() && (text.back() == '\r' || text.back() == ' '))
+            text.remove_suffix(1);
+        if (text.empty() || text[0] != ':')
             continue;
+        text.remove_prefix(1);
 
-        if (line.size() < 11)
+        if (text.size() < 10 || text.size() % 2 != 0 || text.size() / 2 > rec.size())
+        {
+            report(line_no, "malformed record");
+            continue;
+        }
+        int size = decode_hex(text, rec.data());
+        if (size < 0)
+        {
+            report(line_no, "invalid hex digit");
             continue;
+        }
 
-        auto hex2 = [&](size_t pos) -> uint8_t {
-            return static_cast<uint8_t>(std::stoul(line.substr(pos, 2), nullptr, 16));
-        };
-        auto hex4 = [&](size_t pos) -> uint16_t {
-            return static_cast<uint16_t>((hex2(pos) << 8) | hex2(pos + 2));
-        };
-
-        uint8_t byte_count = 0;
-        uint16_t address = 0;
-        uint8_t rec_type = 0;
-        try
+        uint8_t byte_count = rec[0];
+        if (size != byte_count + 5)
         {
-            byte_count = hex2(1);
-            address = hex4(3);
-            rec_type = hex2(7);
+            report(line_no, "record length does not match byte count");
+            continue;
         }
-        catch (...)
+        uint8_t sum = 0;
+        for (int i = 0; i < size; ++i)
+            sum = static_cast<uint8_t>(sum + rec[i]);
+        if (sum != 0)
         {
+            uint8_t expected = static_cast<uint8_t>(rec[size - 1] - sum);
+            std::ostringstream oss;
+            oss << std::uppercase << std::hex << std::setfill('0')
+                << "checksum mismatch (record has " << std::setw(2)
+                << int(rec[size - 1]) << ", expected " << std::setw(2)
+                << int(expected) << ")";
+            report(line_no, oss.str());
             continue;
         }
 
-        if (line.size() < (11 + static_cast<size_t>(byte_count) * 2))
-            continue;
+        uint16_t address = static_cast<uint16_t>((rec[1] << 8) | rec[2]);
+        uint8_t rec_type = rec[3];
+        const uint8_t *data = rec.data() + 4;
 
         if (rec_type == 0x01)       // EOF
             break;
@@ -90,57 +324,39 @@ ihx_load_result load_ihx(std::istream &in, std::vector<uint8_t> &mem)
             if (byte_count > 0 && base_addr < lowest_data_addr)
                 lowest_data_addr = base_addr;
 
-            for (uint8_t i = 0; i < byte_count; ++i)
+            if (base_addr < mem.size())
+            {
+                size_t n = std::min<size_t>(byte_count, mem.size() - base_addr);
+                std::memcpy(mem.data() + base_addr, data, n);
+            }
+            if (static_cast<size_t>(base_addr) + byte_count > mem.size())
             {
-                uint8_t byte = 0;
-                try { byte = hex2(9 + static_cast<size_t>(i) * 2); }
-                catch (...) { break; }
-                size_t dest = static_cast<size_t>(base_addr + i);
-                if (dest < mem.size())
-                    mem[dest] = byte;
+                std::ostringstream oss;
+                oss << std::uppercase << std::hex << std::setfill('0')
+                    << "data at " << std::setw(5) << base_addr
+                    << " is beyond physical memory (configure more banks)";
+                report(line_no, oss.str());
             }
         }
         else if (rec_type == 0x02 && byte_count >= 2) // extended segment addr
-        {
-            uint16_t seg = 0;
-            try { seg = hex4(9); }
-            catch (...) { continue; }
-            upper_base = static_cast<uint32_t>(seg) << 4;
-        }
+            upper_base = static_cast<uint32_t>((data[0] << 8) | data[1]) << 4;
         else if (rec_type == 0x04 && byte_count >= 2) // extended linear addr
-        {
-            uint16_t upper = 0;
-            try { upper = hex4(9); }
-            catch (...) { continue; }
-            upper_base = static_cast<uint32_t>(upper) << 16;
-        }
+            upper_base = static_cast<uint32_t>((data[0] << 8) | data[1]) << 16;
         else if (rec_type == 0x03 && byte_count >= 4) // start segment addr
         {
-            uint16_t cs = 0, ip = 0;
-            try
-            {
-                cs = hex4(9);
-                ip = hex4(13);
-            }
-            catch (...) { continue; }
-            explicit_entry = (static_cast<uint32_t>(cs) << 4) + ip;
+            uint32_t cs = static_cast<uint32_t>((data[0] << 8) | data[1]);
+            uint32_t ip = static_cast<uint32_t>((data[2] << 8) | data[3]);
+            explicit_entry = (cs << 4) + ip;
         }
         else if (rec_type == 0x05 && byte_count >= 4) // start linear addr
         {
-            uint32_t eip = 0;
-            try
-            {
-                eip = (static_cast<uint32_t>(hex2(9)) << 24) |
-                      (static_cast<uint32_t>(hex2(11)) << 16) |
-                      (static_cast<uint32_t>(hex2(13)) << 8) |
-                      static_cast<uint32_t>(hex2(15));
-            }
-            catch (...) { continue; }
-            explicit_entry = eip;
+            explicit_entry = (static_cast<uint32_t>(data[0]) << 24) |
+                             (static_cast<uint32_t>(data[1]) << 16) |
+                             (static_cast<uint32_t>(data[2]) << 8) |
+                             static_cast<uint32_t>(data[3]);
         }
     }
 
-    ihx_load_result result;
     if (explicit_entry.has_value())
     {
         result.entry = static_cast<uint16_t>(*explicit_entry & 0xFFFF);
@@ -152,6 +368,98 @@ ihx_load_result load_ihx(std::istream &in, std::vector<uint8_t> &mem)
     return result;
 }
 
+struct program_load_result {
+    bool loaded = false;
+    bool ihx = false;
+    ihx_load_result ihx_result;
+};
+
+// Load a program image (Intel HEX or raw binary) into memory.
+program_load_result load_program(const std::string &bin_path,
+                                 std::vector<uint8_t> &mem, std::ostream &log)
+{
+    program_load_result result;
+    std::string ext;
+    try { ext = std::filesystem::path(bin_path).extension().string(); }
+    catch (...) {}
+    result.ihx = ext == ".ihx" || ext == ".hex";
+
+    std::ifstream bin_file(bin_path, result.ihx ? std::ios::in : std::ios::binary);
+    if (!bin_file)
+    {
+        log << "[launch] ERROR: Cannot open program file: " << bin_path << std::endl;
+        return result;
+    }
+
+    if (result.ihx)
+    {
+        result.ihx_result = load_ihx(bin_file, mem);
+        for (const auto &message : result.ihx_result.diagnostics)
+            log << "[launch] WARNING: " << bin_path << ": " << message << std::endl;
+        if (result.ihx_result.errors > result.ihx_result.diagnostics.size())
+            log << "[launch] WARNING: " << bin_path << ": "
+                << result.ihx_result.errors - result.ihx_result.diagnostics.size()
+                << " more bad records skipped" << std::endl;
+    }
+    else
+    {
+        // Raw binary load has no embedded metadata.
+        bin_file.read(reinterpret_cast<char *>(mem.data()), mem.size());
+    }
+    result.loaded = true;
+    log << "[launch] Loaded program: " << bin_path << std::endl;
+    return result;
+}
+
+// Parse the CDB text file, nullopt if it is missing or fails to parse.
+std::optional<std::vector<sdcc::cdbg_info_module>> parse_cdb(
+    const std::filesystem::path &cdb_path, std::ostream &log)
+{
+    if (!std::filesystem::exists(cdb_path))
+    {
+        log << "[launch] No CDB file found at: " << cdb_path.string() << std::endl;
+        return std::nullopt;
+    }
+    sdcc::cdb_parser parser;
+    auto modules = parser.parse(cdb_path.string());
+    if (!modules)
+        log << "[launch] WARNING: Failed to parse CDB: " << cdb_path.string() << std::endl;
+    return modules;
+}
+
+// Parse the MAP text file, nullopt if it is missing or fails to parse.
+std::optional<sdcc::map_info> parse_map(const std::filesystem::path &map_path,
+                                        std::ostream &log)
+{
+    if (!std::filesystem::exists(map_path))
+    {
+        log << "[launch] No MAP file found at: " << map_path.string() << std::endl;
+        return std::nullopt;
+    }
+    sdcc::map_parser parser;
+    auto map = parser.parse(map_path.string());
+    if (!map)
+        log << "[launch] WARNING: Failed to parse MAP: " << map_path.string() << std::endl;
+    return map;
+}
+
+// Run fn and add its wall time in milliseconds to ms.
+template <typename F>
+auto timed(double &ms, F &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    struct stop_watch {
+        double &ms;
+        std::chrono::steady_clock::time_point start;
+        ~stop_watch()
+        {
+            ms += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+    } watch{ms, start};
+    return fn();
+}
+
 } // anonymous namespace
 
 namespace handlers {
@@ -166,14 +474,59 @@ public:
         auto r = dap::launch_request::from(req);
         auto start_override = parse_start_address_arg(r.arguments);
 
+        ctx_.stop_execution();
+        ctx_.stop_recording();
         z80ex_reset(ctx_.cpu());
-        std::fill(ctx_.memory().begin(), ctx_.memory().end(), 0);
+        ctx_.reset_call_stack();
+        ctx_.clear_devices();
+        apply_profile(select_profile(r.arguments), ctx_);
+        // The memory was reconfigured; the client sets them again.
+        ctx_.set_data_breakpoints({});
+        // "profile": true, "calls" to profile the call graph too, or
+        // "sample" to sample the PC every "sampleInterval" T-states.
+        ctx_.profile().clear();
+        ctx_.call_graph().clear();
+        ctx_.sampler().clear();
+        ctx_.stop_sampling();
+        {
+            const auto profile = r.arguments.contains("profile")
+                ? r.arguments["profile"] : nlohmann::json();
+            std::string mode = profile.is_string() ? profile.get<std::string>() : "";
+            if (mode == "sample")
+            {
+                auto interval = r.arguments.contains("sampleInterval")
+                    ? parse_number_arg(r.arguments["sampleInterval"]) : std::nullopt;
+                auto buffer = r.arguments.contains("sampleBuffer")
+                    ? parse_number_arg(r.arguments["sampleBuffer"]) : std::nullopt;
+                ctx_.set_profiling(false);
+                ctx_.start_sampling(interval && *interval ? *interval : 10000,
+                                    buffer ? *buffer : 0x10000);
+            }
+            else
+                ctx_.set_profiling(mode == "calls" ||
+                                   (profile.is_boolean() && profile.get<bool>()),
+                                   mode == "calls");
+        }
+
+        // "coverage": true writes <program>.info on disconnect, a string
+        // names the file.
+        {
+            std::string path;
+            const auto coverage = r.arguments.contains("coverage")
+                ? r.arguments["coverage"] : nlohmann::json();
+            if (coverage.is_string())
+                path = coverage.get<std::string>();
+            else if (coverage.is_boolean() && coverage.get<bool>() &&
+                     r.arguments.contains("program") && r.arguments["program"].is_string())
+                path = std::filesystem::path(r.arguments["program"].get<std::string>())
+                           .replace_extension(".info").string();
+            ctx_.coverage().clear();
+            ctx_.set_coverage_path(path);
+            ctx_.set_coverage(!path.empty());
+        }
         ctx_.set_virtual_lst_source_reference(1);
         ctx_.clear_source_cache();
-        ctx_.set_cdb_modules({});
-        ctx_.set_source_roots({});
-        ctx_.set_map_symbols({});
-        ctx_.set_map_segments({});
+        ctx_.reset_debug_info();
 
         uint16_t entry = 0x0000;
         std::string entry_reason = "default 0x0000";
@@ -186,40 +539,10 @@ public:
         if (r.arguments.contains("program"))
         {
             std::string bin_path = r.arguments["program"];
-            std::string ext;
-            try { ext = std::filesystem::path(bin_path).extension().string(); }
-            catch (...) {}
-
-            std::ifstream bin_file(bin_path, (ext == ".ihx" || ext == ".hex")
-                                             ? std::ios::in : std::ios::binary);
-            if (bin_file)
-            {
-                if (ext == ".ihx" || ext == ".hex")
-                {
-                    auto load_result = load_ihx(bin_file, ctx_.memory());
-                    if (!start_override)
-                    {
-                        entry = load_result.entry;
-                        entry_reason = load_result.explicit_start
-                            ? "from IHX start address record"
-                            : "from IHX lowest data address";
-                    }
-                }
-                else
-                {
-                    // Raw binary load has no embedded metadata.
-                    bin_file.read(reinterpret_cast<char *>(ctx_.memory().data()),
-                                  ctx_.memory().size());
-                }
-                std::cerr << "[launch] Loaded program: " << bin_path << std::endl;
-            }
-            else
-            {
-                std::cerr << "[launch] ERROR: Cannot open program file: " << bin_path << std::endl;
-            }
-
-            // Try to load CDB for C source mapping.
             namespace fs = std::filesystem;
+
+            // CDB for C source mapping, MAP for symbols/segments and C$
+            // file/line fallback.
             fs::path cdb_path;
             if (r.arguments.contains("cdbFile") &&
                 r.arguments["cdbFile"].is_string())
@@ -227,26 +550,6 @@ public:
             else
                 cdb_path = fs::path(bin_path).replace_extension(".cdb");
 
-            if (fs::exists(cdb_path))
-            {
-                sdcc::cdb_parser parser;
-                auto modules = parser.parse(cdb_path.string());
-                if (modules)
-                {
-                    std::cerr << "[launch] Loaded CDB: " << cdb_path.string()
-                              << " (" << modules->size() << " modules";
-                    size_t total_lines = 0;
-                    for (auto &m : *modules) total_lines += m.lines.size();
-                    std::cerr << ", " << total_lines << " line mappings)" << std::endl;
-                    ctx_.set_cdb_modules(std::move(*modules));
-                }
-                else
-                    std::cerr << "[launch] WARNING: Failed to parse CDB: " << cdb_path.string() << std::endl;
-            }
-            else
-                std::cerr << "[launch] No CDB file found at: " << cdb_path.string() << std::endl;
-
-            // Try to load MAP for symbols/segments and C$ file/line fallback.
             fs::path map_path;
             if (r.arguments.contains("mapFile") &&
                 r.arguments["mapFile"].is_string())
@@ -254,23 +557,87 @@ public:
             else
                 map_path = fs::path(bin_path).replace_extension(".map");
 
-            if (fs::exists(map_path))
+            // Parsed debug info is cached next to the program and reused
+            // while the CDB and MAP files are unchanged.
+            bool use_cache = !r.arguments.contains("debugInfoCache") ||
+                             !r.arguments["debugInfoCache"].is_boolean() ||
+                             r.arguments["debugInfoCache"].get<bool>();
+            sdcc::debug_cache cache(
+                fs::path(bin_path).replace_extension(".dbgcache").string());
+
+            // The program image, CDB and MAP are independent: load the
+            // image and parse the CDB on worker threads while this thread
+            // reads the cache or parses the MAP. Each stage logs into its
+            // own buffer, printed in order once all of them are joined.
+            std::ostringstream program_log, cdb_log, map_log;
+            double program_ms = 0, cache_ms = 0, cdb_ms = 0, map_ms = 0;
+            double index_ms = 0, breakpoints_ms = 0;
+
+            auto program_task = std::async(std::launch::async, [&] {
+                return timed(program_ms, [&] {
+                    return load_program(bin_path, ctx_.memory().store(), program_log);
+                });
+            });
+
+            auto info = use_cache
+                ? timed(cache_ms, [&] {
+                      return cache.load(cdb_path.string(), map_path.string());
+                  })
+                : std::nullopt;
+            bool from_cache = info.has_value();
+            if (!from_cache)
             {
-                sdcc::map_parser parser;
-                auto map = parser.parse(map_path.string());
+                auto cdb_task = std::async(std::launch::async, [&] {
+                    return timed(cdb_ms, [&] { return parse_cdb(cdb_path, cdb_log); });
+                });
+                auto map = timed(map_ms, [&] { return parse_map(map_path, map_log); });
+                auto modules = cdb_task.get();
+
+                info.emplace();
+                if (modules)
+                {
+                    info->has_cdb = true;
+                    info->modules = std::move(*modules);
+                }
                 if (map)
                 {
-                    ctx_.set_map_symbols(map->symbols);
-                    ctx_.set_map_segments(map->segments);
-                    std::cerr << "[launch] Loaded MAP: " << map_path.string()
-                              << " (" << map->segments.size() << " segments, "
-                              << map->symbols.size() << " symbols)" << std::endl;
+                    info->has_map = true;
+                    info->map = std::move(*map);
                 }
-                else
-                    std::cerr << "[launch] WARNING: Failed to parse MAP: " << map_path.string() << std::endl;
+                if (use_cache && !cache.save(*info, cdb_path.string(), map_path.string()))
+                    map_log << "[launch] WARNING: Cannot write debug info cache: "
+                            << cache.path() << std::endl;
+            }
+            auto program = program_task.get();
+
+            std::cerr << program_log.str() << cdb_log.str() << map_log.str();
+            if (program.loaded && program.ihx && !start_override)
+            {
+                entry = program.ihx_result.entry;
+                entry_reason = program.ihx_result.explicit_start
+                    ? "from IHX start address record"
+                    : "from IHX lowest data address";
+            }
+            if (from_cache)
+                std::cerr << "[launch] Loaded debug info cache: " << cache.path() << std::endl;
+
+            if (info->has_cdb)
+            {
+                size_t total_lines = 0;
+                for (auto &m : info->modules) total_lines += m.lines.size();
+                std::cerr << "[launch] Loaded CDB: " << cdb_path.string()
+                          << " (" << info->modules.size() << " modules, "
+                          << total_lines << " line mappings)" << std::endl;
+                ctx_.set_cdb_modules(std::move(info->modules));
+            }
+            if (info->has_map)
+            {
+                std::cerr << "[launch] Loaded MAP: " << map_path.string()
+                          << " (" << info->map.segments.size() << " segments, "
+                          << info->map.symbols.size() << " symbols)" << std::endl;
+                ctx_.set_map_symbols(std::move(info->map.symbols));
+                ctx_.set_map_segments(std::move(info->map.segments));
             }
-            else
-                std::cerr << "[launch] No MAP file found at: " << map_path.string() << std::endl;
 
             // Determine source root for resolving relative paths in CDB.
             if (r.arguments.contains("sourceRoot"))
@@ -299,7 +666,16 @@ public:
                 }
             }
             ctx_.set_source_roots(std::move(roots));
-            ctx_.rebuild_source_breakpoint_addresses();
+            timed(index_ms, [&] { ctx_.index_debug_info(); });
+            timed(breakpoints_ms, [&] { ctx_.rebuild_source_breakpoint_addresses(); });
+
+            std::ostringstream timings;
+            timings << std::fixed << std::setprecision(1)
+                    << "program " << program_ms << ", cache " << cache_ms
+                    << ", cdb " << cdb_ms << ", map " << map_ms
+                    << ", index " << index_ms
+                    << ", breakpoints " << breakpoints_ms;
+            std::cerr << "[launch] Timings (ms): " << timings.str() << std::endl;
 
             std::string base;
             try { base = fs::path(bin_path).stem().string(); }
@@ -317,6 +693,31 @@ public:
                   << std::hex << entry << std::dec
                   << " (" << entry_reason << ")" << std::endl;
 
+        ctx_.set_restart_point();
+
+        // "reverse": true, or { "interval": T-states between snapshots,
+        // "budget": bytes of history }, records for stepBack and
+        // reverseContinue from the entry point on.
+        if (r.arguments.contains("reverse"))
+        {
+            const auto &reverse = r.arguments["reverse"];
+            auto setting = [&reverse](const char *key, uint32_t fallback)
+            {
+                auto value = reverse.is_object() && reverse.contains(key)
+                    ? parse_number_arg(reverse[key]) : std::nullopt;
+                return value && *value ? *value : fallback;
+            };
+            if (reverse.is_object() || (reverse.is_boolean() && reverse.get<bool>()))
+            {
+                uint32_t interval = setting("interval", default_history_interval);
+                uint32_t budget = setting("budget", default_history_budget);
+                ctx_.start_recording(interval, budget);
+                std::cerr << "[launch] Recording for reverse execution: snapshot every "
+                          << interval << " T-states, " << budget / 1024
+                          << " KB budget" << std::endl;
+            }
+        }
+
         ctx_.set_launched(true);
         ctx_.set_pending_entry_stop(true);
 
@@ -327,6 +728,9 @@ public:
     }
 
 private:
+    static constexpr uint32_t default_history_interval = 100000;
+    static constexpr uint32_t default_history_budget = 64 << 20;
+
     dbg &ctx_;
 };
 
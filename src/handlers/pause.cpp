@@ -0,0 +1,37 @@
+// pause.cpp — DAP "pause" request handler.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class pause_handler : public dap::request_handler {
+public:
+    pause_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "pause"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        auto r = dap::pause_request::from(req);
+
+        // The execution thread sends the stopped event once it parks.
+        // Pausing a CPU that is already stopped is a no-op.
+        ctx_.request_pause();
+
+        dap::response resp(r.seq, r.command);
+        return resp.success(true).result({}).str();
+    }
+
+private:
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_pause(dbg &ctx)
+{
+    return std::make_unique<pause_handler>(ctx);
+}
+
+} // namespace handlers
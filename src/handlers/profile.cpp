@@ -0,0 +1,161 @@
+// profile.cpp — custom "profile" request handler.
+//
+// Controls the execution profiler and reports its results. Arguments:
+//   action:    "start", "stop", "clear" or "report" (the default)
+//   callGraph: with "start", also profile the call graph
+//   sampleInterval: with "start", sample the PC every this many T-states
+//              instead of counting every instruction
+//   sampleBuffer: samples kept (default 65536, the oldest are dropped)
+//   path:      also write the full report to this file
+//   format:    "json", "csv" or "folded" (call graph stacks, or sampled
+//              stacks without a call graph) for the file; by default taken
+//              from the path's extension, json otherwise
+//   limit:     rows per table in the response (default 100, 0 for all)
+// Every action answers with the current report.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class profile_handler : public dap::request_handler {
+public:
+    profile_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "profile"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        const auto &args = req.arguments;
+        auto text = [&args](const char *key, const char *fallback)
+        {
+            return args.is_object() && args.contains(key) && args[key].is_string()
+                ? args[key].get<std::string>() : std::string(fallback);
+        };
+        std::string action = text("action", "report");
+        std::string path = text("path", "");
+        auto number = [&args](const char *key, size_t fallback)
+        {
+            return args.is_object() && args.contains(key) && args[key].is_number_unsigned()
+                ? args[key].get<size_t>() : fallback;
+        };
+        size_t limit = number("limit", 100);
+        auto interval = static_cast<uint32_t>(
+            std::min<size_t>(number("sampleInterval", 0), UINT32_MAX));
+        size_t buffer = number("sampleBuffer", default_sample_buffer);
+
+        dap::response resp(req.seq, req.command);
+        if (action != "start" && action != "stop" && action != "clear" &&
+            action != "report")
+        {
+            resp.success(false).message("Unknown profile action '" + action + "'");
+            return resp.str();
+        }
+
+        bool calls = args.is_object() && args.contains("callGraph") &&
+                     args["callGraph"].is_boolean() && args["callGraph"].get<bool>();
+
+        // Copy the counters while the CPU is parked and aggregate after.
+        exec_profile profile;
+        std::vector<call_graph::node> graph;
+        std::vector<pc_sampler::sample> samples;
+        bool profiling = false;
+        bool profiling_calls = false;
+        bool sampling = false;
+        uint32_t sample_interval = 0;
+        uint64_t samples_taken = 0;
+        size_t sample_capacity = 0;
+        {
+            execution_pause guard(ctx_);
+            if (action == "start" && interval)
+            {
+                ctx_.set_profiling(false);
+                ctx_.start_sampling(interval, buffer);
+            }
+            else if (action == "start")
+            {
+                ctx_.stop_sampling();
+                ctx_.set_profiling(true, calls);
+            }
+            else if (action == "stop")
+            {
+                ctx_.set_profiling(false);
+                ctx_.stop_sampling();
+            }
+            else if (action == "clear")
+            {
+                ctx_.profile().clear();
+                ctx_.call_graph().clear();
+                ctx_.sampler().clear();
+            }
+            profile = ctx_.profile();
+            graph = ctx_.call_graph().nodes();
+            samples = ctx_.sampler().samples();
+            profiling = ctx_.profiling();
+            profiling_calls = ctx_.profiling_calls();
+            sampling = ctx_.sampling();
+            sample_interval = ctx_.sampler().interval();
+            samples_taken = ctx_.sampler().taken();
+            sample_capacity = ctx_.sampler().capacity();
+        }
+        auto summary = summarize_profile(ctx_, profile);
+        summarize_call_graph(ctx_, graph, summary);
+        auto body = profile_json(summary, limit);
+        body["profiling"] = profiling;
+        body["callGraph"] = profiling_calls;
+        body["frequency"] = ctx_.scheduler().frequency();
+
+        profile_summary sampled;
+        if (!samples.empty())
+        {
+            sampled = summarize_samples(ctx_, samples, sample_interval);
+            auto report = profile_json(sampled, limit);
+            report["interval"] = sample_interval;
+            report["taken"] = samples_taken;
+            report["capacity"] = sample_capacity;
+            body["samples"] = std::move(report);
+        }
+        body["sampling"] = sampling;
+
+        if (!path.empty())
+        {
+            std::string format = text("format",
+                path.ends_with(".csv") ? "csv" : path.ends_with(".folded") ? "folded" : "json");
+            std::ofstream out(path, std::ios::binary);
+            // Sampling replaces the full profile, so whichever has data
+            // is written; the full profile wins if both have.
+            bool exact = summary.count != 0 || samples.empty();
+            if (format == "csv")
+                out << profile_csv(exact ? summary : sampled);
+            else if (format == "folded")
+                out << (graph.size() > 1 || samples.empty()
+                    ? folded_stacks(ctx_, graph)
+                    : folded_stacks(ctx_, samples, sample_interval));
+            else
+                out << profile_json(exact ? summary : sampled, 0).dump(2) << '\n';
+            if (!out)
+            {
+                resp.success(false).message("Cannot write profile to " + path);
+                return resp.str();
+            }
+            body["path"] = path;
+        }
+
+        resp.success(true).result(body);
+        return resp.str();
+    }
+
+private:
+    static constexpr size_t default_sample_buffer = 0x10000;
+
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_profile(dbg &ctx)
+{
+    return std::make_unique<profile_handler>(ctx);
+}
+
+} // namespace handlers
@@ -17,9 +17,13 @@ public:
     {
         auto r = dap::read_memory_request::from(req);
 
+        // Memory references are physical addresses, so any bank can be
+        // read whichever is mapped at the moment.
         size_t addr = static_cast<size_t>(r.memory_reference);
-        auto &mem = ctx_.memory();
-        int count = std::min(r.count, static_cast<int>(mem.size() - addr));
+        execution_pause guard(ctx_);
+        const auto &mem = ctx_.memory().store();
+        int count = addr < mem.size()
+            ? std::min(r.count, static_cast<int>(mem.size() - addr)) : 0;
 
         std::ostringstream hexstr;
         for (int i = 0; i < count; ++i)
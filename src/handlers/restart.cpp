@@ -0,0 +1,51 @@
+// restart.cpp — DAP "restart" request handler.
+//
+// Puts the machine back to the state it was launched in, from the
+// snapshot taken at launch, instead of loading the program and its debug
+// info again. Breakpoints, profiles and coverage carry over. Changed
+// launch arguments (and a rebuilt program) need a new session.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class restart_handler : public dap::request_handler {
+public:
+    restart_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "restart"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        dap::response resp(req.seq, req.command);
+        std::string error = "Nothing has been launched";
+        ctx_.stop_execution();
+        if (!ctx_.launched() || !ctx_.restart(error))
+        {
+            resp.success(false).message(error);
+            return resp.str();
+        }
+
+        // Stopped at the entry point again, reported after the response
+        // like the first entry stop.
+        std::thread([this]()
+                    {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ctx_.send_stopped_event("entry"); })
+            .detach();
+        return resp.success(true).result({}).str();
+    }
+
+private:
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_restart(dbg &ctx)
+{
+    return std::make_unique<restart_handler>(ctx);
+}
+
+} // namespace handlers
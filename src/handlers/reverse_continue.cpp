@@ -0,0 +1,47 @@
+// reverse_continue.cpp — DAP "reverseContinue" request handler.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class reverse_continue_handler : public dap::request_handler {
+public:
+    reverse_continue_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "reverseContinue"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        auto r = dap::reverse_continue_request::from(req);
+
+        dap::response resp(r.seq, r.command);
+        if (!ctx_.recording())
+        {
+            resp.success(false).message(
+                "No execution history: set \"reverse\" in the launch configuration");
+            return resp.str();
+        }
+
+        // The execution thread reports the stop with a stopped event.
+        if (!ctx_.start_step(exec_mode::reverse_continue, false))
+        {
+            resp.success(false).message("Pause before running backwards");
+            return resp.str();
+        }
+        resp.success(true).result({{"allThreadsContinued", true}});
+        return resp.str();
+    }
+
+private:
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_reverse_continue(dbg &ctx)
+{
+    return std::make_unique<reverse_continue_handler>(ctx);
+}
+
+} // namespace handlers
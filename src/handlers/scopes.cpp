@@ -17,6 +17,7 @@ public:
     {
         auto r = dap::scopes_request::from(req);
         nlohmann::json scopes = nlohmann::json::array();
+        execution_pause guard(ctx_);
         scopes.push_back({
             {"name", "Registers"},
             {"variablesReference", 100},
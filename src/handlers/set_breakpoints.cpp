@@ -28,19 +28,25 @@ public:
                 source_path = src["name"].get<std::string>();
         }
 
-        std::vector<int> lines;
+        std::vector<source_breakpoint> breakpoints;
         if (r.arguments.contains("breakpoints"))
         {
             for (const auto &bp : r.arguments["breakpoints"])
             {
-                int line = bp.value("line", 1);
-                lines.push_back(line);
+                source_breakpoint sb;
+                sb.line = bp.value("line", 1);
+                sb.condition = bp.value("condition", "");
+                sb.hit_condition = bp.value("hitCondition", "");
+                breakpoints.push_back(std::move(sb));
             }
         }
 
-        ctx_.set_source_breakpoints_for_file(source_path, std::move(lines));
-        auto bps = ctx_.resolve_source_breakpoints_for_file(source_path);
+        // Rebuilding compiles the conditions, so it comes first: the
+        // response reports the ones that don't compile.
+        execution_pause guard(ctx_);
+        ctx_.set_source_breakpoints_for_file(source_path, std::move(breakpoints));
         ctx_.rebuild_source_breakpoint_addresses();
+        auto bps = ctx_.resolve_source_breakpoints_for_file(source_path);
 
         dap::response resp(r.seq, r.command);
         resp.success(true).result({{"breakpoints", bps}});
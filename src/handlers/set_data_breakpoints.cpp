@@ -0,0 +1,66 @@
+// set_data_breakpoints.cpp — DAP "setDataBreakpoints" request handler.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class set_data_breakpoints_handler : public dap::request_handler {
+public:
+    set_data_breakpoints_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "setDataBreakpoints"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        auto r = dap::set_data_breakpoints_request::from(req);
+
+        // Data ids come from dataBreakpointInfo: "<address>/<size>/<name>".
+        std::vector<data_breakpoint> watches;
+        std::vector<nlohmann::json> breakpoints;
+        for (const auto &bp : r.breakpoints)
+        {
+            std::string id = bp.value("dataId", "");
+            std::string access = bp.value("accessType", "write");
+            data_breakpoint watch;
+            unsigned long address = 0, size = 0;
+            size_t name_pos = 0;
+            if (std::sscanf(id.c_str(), "%lx/%lu/%zn", &address, &size, &name_pos) < 2 ||
+                !name_pos || !size || size > 0xFFFF)
+            {
+                breakpoints.push_back({{"verified", false},
+                                       {"message", "Unknown data breakpoint '" + id + "'"}});
+                continue;
+            }
+            watch.address = static_cast<uint32_t>(address);
+            watch.size = static_cast<uint16_t>(size);
+            watch.name = id.substr(name_pos);
+            watch.access = access == "read" ? memory_map::watch_read
+                : access == "readWrite" ? memory_map::watch_read | memory_map::watch_write
+                : memory_map::watch_write;
+            watches.push_back(std::move(watch));
+            breakpoints.push_back({{"verified", true}});
+        }
+
+        {
+            execution_pause guard(ctx_);
+            ctx_.set_data_breakpoints(std::move(watches));
+        }
+
+        dap::response resp(r.seq, r.command);
+        resp.success(true).result({{"breakpoints", breakpoints}});
+        return resp.str();
+    }
+
+private:
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_set_data_breakpoints(dbg &ctx)
+{
+    return std::make_unique<set_data_breakpoints_handler>(ctx);
+}
+
+} // namespace handlers
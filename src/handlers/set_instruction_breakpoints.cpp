@@ -17,19 +17,24 @@ public:
     {
         auto r = dap::set_instruction_breakpoints_request::from(req);
 
-        ctx_.instruction_breakpoints().clear();
+        // References are physical addresses, as handed out in stack
+        // frames: bank n of a window is at (n << 16) | address.
+        std::vector<uint32_t> addresses;
         for (const auto &bp : r.breakpoints)
         {
             if (bp.contains("instructionReference"))
             {
                 std::string addr_str = bp["instructionReference"];
-                uint16_t addr = std::stoul(addr_str, nullptr, 16);
-                ctx_.instruction_breakpoints().push_back(addr);
+                auto addr = static_cast<uint32_t>(std::stoul(addr_str, nullptr, 16));
+                addresses.push_back(addr);
             }
         }
 
+        execution_pause guard(ctx_);
+        ctx_.set_instruction_breakpoints(std::move(addresses));
+
         std::vector<nlohmann::json> breakpoints;
-        for (uint16_t addr : ctx_.instruction_breakpoints())
+        for (uint32_t addr : ctx_.instruction_breakpoints())
         {
             breakpoints.push_back({{"verified", true},
                                    {"instructionReference", ctx_.format_hex(addr, 4)}});
@@ -0,0 +1,129 @@
+// snapshot.cpp — custom "snapshot" request handler.
+//
+// Saves and restores whole machine states (see dbg::save_snapshot).
+// Arguments:
+//   action: "save" (the default), "restore" or "delete"
+//   id:     with "restore" and "delete", a snapshot returned by "save"
+//   path:   with "save", also write the snapshot to this file; with
+//           "restore", restore the snapshot in this file instead of an id
+// Snapshots are kept by the adapter until deleted, and only restore on
+// the program image they were taken from. Restoring needs the CPU to be
+// stopped and reports a stop at the restored state.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+#include <map>
+
+namespace handlers {
+
+class snapshot_handler : public dap::request_handler {
+public:
+    snapshot_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "snapshot"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        const auto &args = req.arguments;
+        auto text = [&args](const char *key, const char *fallback)
+        {
+            return args.is_object() && args.contains(key) && args[key].is_string()
+                ? args[key].get<std::string>() : std::string(fallback);
+        };
+        std::string action = text("action", "save");
+        std::string path = text("path", "");
+        int id = args.is_object() && args.contains("id") && args["id"].is_number_integer()
+            ? args["id"].get<int>() : 0;
+
+        dap::response resp(req.seq, req.command);
+        auto fail = [&resp](const std::string &message)
+        {
+            resp.success(false).message(message);
+            return resp.str();
+        };
+
+        if (action == "save")
+        {
+            std::vector<uint8_t> blob;
+            {
+                execution_pause guard(ctx_);
+                blob = ctx_.save_snapshot();
+            }
+            if (!path.empty())
+            {
+                std::ofstream out(path, std::ios::binary);
+                out.write(reinterpret_cast<const char *>(blob.data()),
+                          static_cast<std::streamsize>(blob.size()));
+                if (!out)
+                    return fail("Cannot write snapshot to " + path);
+            }
+            id = next_id_++;
+            nlohmann::json body = {{"id", id}, {"bytes", blob.size()}};
+            if (!path.empty())
+                body["path"] = path;
+            saved_[id] = std::move(blob);
+            resp.success(true).result(body);
+            return resp.str();
+        }
+
+        if (action == "delete")
+        {
+            if (!saved_.erase(id))
+                return fail("No snapshot " + std::to_string(id));
+            resp.success(true).result({{"id", id}});
+            return resp.str();
+        }
+
+        if (action != "restore")
+            return fail("Unknown snapshot action '" + action + "'");
+
+        std::vector<uint8_t> file;
+        const std::vector<uint8_t> *blob = nullptr;
+        if (!path.empty())
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+                return fail("Cannot read snapshot " + path);
+            file.assign(std::istreambuf_iterator<char>(in), {});
+            blob = &file;
+        }
+        else if (auto it = saved_.find(id); it != saved_.end())
+            blob = &it->second;
+        else
+            return fail("No snapshot " + std::to_string(id));
+
+        if (ctx_.running())
+            return fail("Pause before restoring a snapshot");
+        std::string error;
+        if (!ctx_.load_snapshot(*blob, error))
+            return fail(error);
+
+        std::thread([this]()
+                    {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ctx_.send_stopped_event("goto", "Snapshot restored"); })
+            .detach();
+        nlohmann::json body = {{"bytes", blob->size()}};
+        if (path.empty())
+            body["id"] = id;
+        else
+            body["path"] = path;
+        resp.success(true).result(body);
+        return resp.str();
+    }
+
+private:
+    dbg &ctx_;
+    std::map<int, std::vector<uint8_t>> saved_;
+    int next_id_ = 1;
+};
+
+std::unique_ptr<dap::request_handler> make_snapshot(dbg &ctx)
+{
+    return std::make_unique<snapshot_handler>(ctx);
+}
+
+} // namespace handlers
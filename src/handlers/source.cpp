@@ -38,9 +38,11 @@ std::string replace_hex_operands(
 
         if (parsed)
         {
-            auto sym = ctx.lookup_symbol_exact(addr);
+            // Operands are CPU addresses, named for the banks mapped now.
+            uint32_t physical = ctx.memory().physical(addr);
+            auto sym = ctx.lookup_symbol_exact(physical);
             if (!sym)
-                sym = ctx.lookup_symbol(addr);
+                sym = ctx.lookup_symbol(physical);
 
             if (sym)
             {
@@ -130,26 +132,30 @@ public:
             return resp.str();
         }
 
+        // Disassembling reads PC and memory: park a running CPU first.
+        execution_pause guard(ctx_);
         std::ostringstream oss;
         char dasm_buf[64];
         uint32_t addr = z80ex_get_reg(ctx_.cpu(), regPC);
 
+        // Disassemble what the CPU sees, labelled with physical addresses.
         auto &mem = ctx_.memory();
-        for (int i = 0; i < 256 && addr < mem.size();)
+        for (int i = 0; i < 256 && addr < 0x10000;)
         {
             int ts1 = 0, ts2 = 0;
             int ilen = z80ex_dasm(
                 dasm_buf, sizeof(dasm_buf), 0, &ts1, &ts2,
-                dbg::dasm_readbyte_cb, addr, &mem);
+                dbg::dasm_readbyte_cb, static_cast<Z80EX_WORD>(addr), &mem);
 
             oss << "      " << std::uppercase << std::setfill('0')
-                << std::setw(6) << std::hex << addr << " ";
+                << std::setw(6) << std::hex
+                << mem.physical(static_cast<uint16_t>(addr)) << " ";
 
             int opcode_chars = 0;
-            for (int j = 0; j < ilen && (addr + j) < mem.size(); ++j)
+            for (int j = 0; j < ilen && (addr + j) < 0x10000; ++j)
             {
                 oss << std::setw(2) << std::setfill('0') << std::hex
-                    << (int)mem[addr + j] << " ";
+                    << (int)mem.read(static_cast<uint16_t>(addr + j)) << " ";
                 opcode_chars += 3;
             }
             for (; opcode_chars < 8; ++opcode_chars)
@@ -16,16 +16,60 @@ public:
     std::string handle(const dap::request &req) override
     {
         auto r = dap::stack_trace_request::from(req);
-        uint16_t pc = z80ex_get_reg(ctx_.cpu(), regPC);
+        execution_pause guard(ctx_);
 
-        nlohmann::json frame;
+        // Frame 0 is the PC, the callers come from the shadow call stack
+        // (innermost last) and are shown at their call instruction. With
+        // an empty shadow stack they are recovered from the IX frame chain
+        // of the CDB functions instead. Frame addresses are physical, so
+        // banked code shows its bank.
+        const auto &calls = ctx_.call_stack();
+        std::vector<uint32_t> recovered;
+        if (calls.empty())
+            recovered = ctx_.unwind_frame_chain(max_recovered_frames);
+        int callers = static_cast<int>(calls.empty() ? recovered.size() : calls.size());
+        int total = callers + 1;
+        int first = std::clamp(r.start_frame, 0, total);
+        int last = r.levels > 0 ? std::min(total, first + r.levels) : total;
+
+        nlohmann::json frames = nlohmann::json::array();
+        for (int level = first; level < last; ++level)
+        {
+            uint32_t address;
+            if (level == 0)
+                address = ctx_.memory().physical(z80ex_get_reg(ctx_.cpu(), regPC));
+            else if (calls.empty())
+                address = recovered[level - 1];
+            else
+                address = calls[calls.size() - level].call_pc;
+            frames.push_back(make_frame(level, address));
+        }
+
+        dap::response resp(r.seq, r.command);
+        resp.success(true).result({{"stackFrames", frames},
+                                   {"totalFrames", total}});
+        return resp.str();
+    }
+
+private:
+    static constexpr size_t max_recovered_frames = 64;
+
+    nlohmann::json make_frame(int level, uint32_t address)
+    {
+        nlohmann::json frame = {
+            {"id", level + 1},
+            {"memoryReference", ctx_.format_hex(address, 4)},
+            {"instructionReference", ctx_.format_hex(address, 4)},
+            {"column", 1}};
+
+        auto fn = ctx_.lookup_function(address);
 
         // Try C source mapping from CDB first.
-        auto src = ctx_.has_cdb() ? ctx_.lookup_source(pc) : std::nullopt;
+        auto src = ctx_.has_cdb() ? ctx_.lookup_source(address) : std::nullopt;
         if (src)
         {
             std::string name = std::filesystem::path(src->file).filename().string();
-            int source_ref = ctx_.ensure_source_reference(src->file, "text/x-c");
+            int source_ref = ctx_.ensure_source_reference(std::string(src->file), "text/x-c");
             nlohmann::json source = {
                 {"name", name},
                 {"presentationHint", "normal"}};
@@ -37,45 +81,39 @@ public:
                 source["sourceReference"] = 0;
             }
 
-            frame = {
-                {"id", 1},
-                {"name", name + ":" + std::to_string(src->line)},
-                {"memoryReference", ctx_.format_hex(pc, 4)},
-                {"instructionReference", ctx_.format_hex(pc, 4)},
-                {"source", source},
-                {"line", src->line},
-                {"column", 1}};
+            frame["name"] = fn ? fn->name : name + ":" + std::to_string(src->line);
+            frame["source"] = source;
+            frame["line"] = src->line;
+            return frame;
         }
-        else
+
+        auto sym = fn ? std::optional<std::string>(fn->name) : ctx_.lookup_symbol(address);
+        frame["name"] = sym ? *sym : ctx_.format_hex(address, 4);
+
+        if (level > 0)
         {
-            // Fall back to virtual disassembly listing.
-            // Increment the sourceReference so VSCode re-fetches the
-            // content (which starts from the current PC).
-            int source_ref = ctx_.virtual_lst_source_reference() + 1;
-            ctx_.set_virtual_lst_source_reference(source_ref);
-            auto sym = ctx_.lookup_symbol(pc);
-
-            frame = {
-                {"id", 1},
-                {"name", sym ? *sym : ctx_.format_hex(pc, 4)},
-                {"memoryReference", ctx_.format_hex(pc, 4)},
-                {"instructionReference", ctx_.format_hex(pc, 4)},
-                {"source",
-                 {{"name", "z80.s"},
-                  {"sourceReference", source_ref},
-                  {"presentationHint", "deemphasize"},
-                  {"mimeType", "text/x-asm"}}},
-                {"line", 1},
-                {"column", 1}};
+            // The disassembly listing only follows the PC; callers without
+            // source are shown by address alone.
+            frame["line"] = 0;
+            frame["column"] = 0;
+            frame["presentationHint"] = "subtle";
+            return frame;
         }
 
-        dap::response resp(r.seq, r.command);
-        resp.success(true).result({{"stackFrames", {frame}},
-                                   {"totalFrames", 1}});
-        return resp.str();
+        // Fall back to virtual disassembly listing.
+        // Increment the sourceReference so VSCode re-fetches the
+        // content (which starts from the current PC).
+        int source_ref = ctx_.virtual_lst_source_reference() + 1;
+        ctx_.set_virtual_lst_source_reference(source_ref);
+        frame["source"] = {
+            {"name", "z80.s"},
+            {"sourceReference", source_ref},
+            {"presentationHint", "deemphasize"},
+            {"mimeType", "text/x-asm"}};
+        frame["line"] = 1;
+        return frame;
     }
 
-private:
     dbg &ctx_;
 };
 
@@ -0,0 +1,47 @@
+// step_back.cpp — DAP "stepBack" request handler.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dap/dap.h>
+#include <dap/handler.h>
+#include <dbg.h>
+
+namespace handlers {
+
+class step_back_handler : public dap::request_handler {
+public:
+    step_back_handler(dbg &ctx) : ctx_(ctx) {}
+    std::string command() const override { return "stepBack"; }
+
+    std::string handle(const dap::request &req) override
+    {
+        auto r = dap::step_back_request::from(req);
+
+        dap::response resp(r.seq, r.command);
+        if (!ctx_.recording())
+        {
+            resp.success(false).message(
+                "No execution history: set \"reverse\" in the launch configuration");
+            return resp.str();
+        }
+
+        // The execution thread reports the end of the step.
+        if (!ctx_.start_step(exec_mode::step_back, r.granularity == "instruction"))
+        {
+            resp.success(false).message("Pause before stepping");
+            return resp.str();
+        }
+        resp.success(true).result({});
+        return resp.str();
+    }
+
+private:
+    dbg &ctx_;
+};
+
+std::unique_ptr<dap::request_handler> make_step_back(dbg &ctx)
+{
+    return std::make_unique<step_back_handler>(ctx);
+}
+
+} // namespace handlers
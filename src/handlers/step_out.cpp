@@ -16,18 +16,15 @@ public:
     std::string handle(const dap::request &req) override
     {
         auto r = dap::step_out_request::from(req);
-        z80ex_step(ctx_.cpu());
 
+        // The execution thread reports the end of the step.
         dap::response resp(r.seq, r.command);
+        if (!ctx_.start_step(exec_mode::step_out, r.granularity == "instruction"))
+        {
+            resp.success(false).message("Pause before stepping");
+            return resp.str();
+        }
         resp.success(true);
-
-        nlohmann::json j{
-            {"seq", ctx_.next_event_seq()},
-            {"type", "event"},
-            {"event", "stopped"},
-            {"body", {{"reason", "step"}, {"threadId", 1}, {"allThreadsStopped", true}}}};
-        ctx_.send_event(j.dump());
-
         return resp.str();
     }
 
@@ -28,6 +28,8 @@ public:
         }
         else if (r.variables_reference == 101)
         {
+            // The registers change under a running CPU: park it.
+            execution_pause guard(ctx_);
 #define Z80REG(name, regid, width)                                          \
     {                                                                       \
         nlohmann::json v;                                                   \
@@ -73,8 +75,8 @@ public:
                 vars.push_back({
                     {"name", seg.name},
                     {"value",
-                     "addr=" + ctx_.format_hex(static_cast<uint16_t>(seg.address & 0xFFFF), 4) +
-                         ", size=" + ctx_.format_hex(static_cast<uint16_t>(seg.size & 0xFFFF), 4) +
+                     "addr=" + ctx_.format_hex(seg.address, 4) +
+                         ", size=" + ctx_.format_hex(seg.size, 4) +
                          ", " + seg.attributes},
                     {"variablesReference", 0},
                 });
@@ -86,7 +88,7 @@ public:
             {
                 vars.push_back({
                     {"name", sym.name},
-                    {"value", ctx_.format_hex(static_cast<uint16_t>(sym.address & 0xFFFF), 4)},
+                    {"value", ctx_.format_hex(sym.address, 4)},
                     {"variablesReference", 0},
                 });
             }
@@ -0,0 +1,301 @@
+// history.cpp
+// Execution history for reverse debugging.
+//
+// This file implements reverse execution for the `dbg` class. While
+// recording, the CPU loop takes a snapshot of the machine (CPU registers,
+// bank selection, devices and shadow call stack, see machine_state) every
+// snapshot interval, and the memory write callback journals the old value
+// of every byte it overwrites. Memory itself isn't copied: undoing the
+// journal back to a snapshot's entry puts memory back as it was then, so
+// a snapshot costs a few hundred bytes and a write four.
+//
+// Going back to instruction n undoes the journal to the latest snapshot
+// at or before n, restores it and replays forward to n. Emulation is
+// deterministic, so the replay takes the same path as the original run.
+// Searches (reverse continue, stepping back a line) replay one snapshot
+// interval at a time, latest first, and stop at the last match in the
+// first interval that has one, so their cost follows the distance gone
+// back rather than the length of the history.
+//
+// Snapshots are only taken between whole instructions: not after a prefix
+// byte, after EI (the CPU ignores interrupts for one more instruction) or
+// while halted, whose state z80ex keeps to itself. The oldest history is
+// dropped to stay within the memory budget. Rewinding drops the snapshots
+// and journal after the restored position, and replays re-create them.
+//
+// Replays only reproduce what the program did itself. Input injected from
+// outside (text typed into the console device, a loaded snapshot) isn't
+// recorded, so it starts the history over instead: the oldest reachable
+// point is the injection, and replays never cross it.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dbg.h>
+
+namespace {
+
+constexpr uint8_t op_ei = 0xFB;
+
+} // namespace
+
+void dbg::start_recording(uint64_t interval, size_t budget)
+{
+    stop_recording();
+    snapshot_interval_ = interval ? interval : 1;
+    history_budget_ = budget;
+    recording_ = true;
+    // Start from here, or from the first clean boundary after it.
+    next_snapshot_ = scheduler_.now();
+    take_snapshot(0);
+}
+
+void dbg::restart_recording()
+{
+    if (recording_)
+        start_recording(snapshot_interval_, history_budget_);
+}
+
+void dbg::stop_recording()
+{
+    recording_ = false;
+    next_snapshot_ = UINT64_MAX;
+    snapshots_.clear();
+    snapshots_.shrink_to_fit();
+    journal_.clear();
+    journal_.shrink_to_fit();
+    journal_base_ = 0;
+    snapshot_bytes_ = 0;
+}
+
+void dbg::capture_state(machine_state &state) const
+{
+    state.steps = steps_;
+    state.tstates = scheduler_.now();
+    for (int r = regAF; r <= regIFF2; ++r)
+        state.registers[r] = z80ex_get_reg(cpu_, static_cast<Z80_REG_T>(r));
+    state.banks.clear();
+    for (const auto &window : memory_.windows())
+        state.banks.push_back(window.bank);
+    state.devices.clear();
+    platform::state_writer out(state.devices);
+    for (const auto &device : devices_)
+        device->save(out);
+    interrupts_.save(out);
+    state.call_stack = call_stack_;
+}
+
+bool dbg::restore_state(const machine_state &state)
+{
+    if (state.banks.size() != memory_.windows().size())
+        return false;
+
+    // Devices re-arm their timers from the clock, so it goes first. A
+    // blob that doesn't fit the devices puts the current state back.
+    std::vector<uint8_t> current;
+    platform::state_writer out(current);
+    for (const auto &device : devices_)
+        device->save(out);
+    interrupts_.save(out);
+    const uint64_t now = scheduler_.now();
+
+    auto load_devices = [this](const std::vector<uint8_t> &blob)
+    {
+        platform::state_reader in(blob);
+        for (auto &device : devices_)
+            device->load(in);
+        interrupts_.load(in);
+        return in.ok() && !in.remaining();
+    };
+    scheduler_.set_now(state.tstates);
+    if (!load_devices(state.devices))
+    {
+        scheduler_.set_now(now);
+        load_devices(current);
+        return false;
+    }
+
+    z80ex_reset(cpu_);
+    for (int r = regAF; r <= regIFF2; ++r)
+        z80ex_set_reg(cpu_, static_cast<Z80_REG_T>(r), state.registers[r]);
+    for (size_t i = 0; i < state.banks.size(); ++i)
+        memory_.select_bank(i, state.banks[i]);
+    call_stack_ = state.call_stack;
+    call_graph_.reset_path();
+    steps_ = state.steps;
+    if (sampling())
+        sample_timer_->arm(scheduler_.now() + sampler_.interval());
+    return true;
+}
+
+// Called by the CPU loop once the clock passes next_snapshot_; `op` is
+// the opcode of the instruction that just ran.
+void dbg::take_snapshot(uint8_t op)
+{
+    if (op == op_ei || z80ex_last_op_type(cpu_) || z80ex_doing_halt(cpu_))
+        return;
+
+    snapshot snap;
+    capture_state(snap.state);
+    snap.journal = journal_base_ + journal_.size();
+    for (const auto &bc : hit_counted_)
+        snap.hits.emplace_back(bc, bc->hits);
+    snap.bytes = sizeof(snapshot) + snap.state.banks.size() +
+                 snap.state.devices.size() +
+                 snap.state.call_stack.size() * sizeof(call_frame) +
+                 snap.hits.size() * sizeof(snap.hits[0]);
+    snapshot_bytes_ += snap.bytes;
+    snapshots_.push_back(std::move(snap));
+    next_snapshot_ = scheduler_.now() + snapshot_interval_;
+
+    // Replays only re-create history that fitted, and searches index the
+    // snapshots while they replay.
+    if (!replaying_)
+        trim_history();
+}
+
+// Drop the oldest snapshots, and the journal before the oldest one kept,
+// until the history fits the budget. The latest snapshot always stays.
+void dbg::trim_history()
+{
+    while (snapshots_.size() > 1 &&
+           snapshot_bytes_ + journal_.size() * sizeof(uint32_t) > history_budget_)
+    {
+        snapshot_bytes_ -= snapshots_.front().bytes;
+        snapshots_.pop_front();
+        auto drop = static_cast<size_t>(snapshots_.front().journal - journal_base_);
+        journal_.erase(journal_.begin(), journal_.begin() + drop);
+        journal_base_ += drop;
+    }
+}
+
+// Put the machine back to snapshot `index` and forget everything after it.
+void dbg::rewind(size_t index)
+{
+    const auto &snap = snapshots_[index];
+    auto &store = memory_.store();
+    while (journal_base_ + journal_.size() > snap.journal)
+    {
+        uint32_t entry = journal_.back();
+        store[entry >> 8] = static_cast<uint8_t>(entry);
+        journal_.pop_back();
+    }
+    restore_state(snap.state);
+    next_snapshot_ = scheduler_.now() + snapshot_interval_;
+
+    // Hit counts go back with the machine, so that replays count the same
+    // hits again. Breakpoints set since the snapshot count from zero.
+    for (const auto &bc : hit_counted_)
+        bc->hits = 0;
+    for (const auto &[bc, hits] : snap.hits)
+        bc->hits = hits;
+
+    while (snapshots_.size() > index + 1)
+    {
+        snapshot_bytes_ -= snapshots_.back().bytes;
+        snapshots_.pop_back();
+    }
+}
+
+// Run forward to history position `steps`. Returns the stop reason if a
+// pause or silent stop comes first.
+std::optional<const char *> dbg::replay_to(uint64_t steps)
+{
+    while (steps_ < steps)
+    {
+        if (auto stop = poll_stop())
+            return *stop;
+        // Count the hits passed on the way, as the original run did.
+        uint16_t pc = z80ex_get_reg(cpu_, regPC);
+        if (bp_map_[pc] & bp_condition)
+            breakpoint_hit(pc);
+        step_instruction();
+    }
+    return std::nullopt;
+}
+
+// Whether the reverse operation in progress ends where the CPU is now:
+// at a breakpoint, or, stepping back a line, at the start of a line other
+// than the one being stepped (or code without line info) no deeper in
+// the call stack than the step began.
+bool dbg::reverse_stop_here()
+{
+    uint16_t pc = z80ex_get_reg(cpu_, regPC);
+    if ((bp_map_[pc] & ~bp_temp) && breakpoint_hit(pc))
+        return true;
+    if (plan_.mode == exec_mode::reverse_continue || call_stack_.size() > plan_.depth)
+        return false;
+
+    uint32_t at = memory_.physical(pc);
+    if (at > plan_.lo && at < plan_.hi)
+        return false;
+    const auto &entry = line_table_[at];
+    return !entry.line || entry.start == at;
+}
+
+const char *dbg::run_reverse(std::string &description)
+{
+    if (snapshots_.empty())
+    {
+        description = "No execution history";
+        return "step";
+    }
+
+    // Replays run code that was profiled already.
+    const uint8_t instruments = instruments_;
+    instruments_ = 0;
+    replaying_ = true;
+
+    std::optional<const char *> stop;
+    std::optional<uint64_t> found;
+    if (plan_.mode == exec_mode::step_back && plan_.instruction)
+    {
+        if (steps_ > snapshots_.front().state.steps)
+            found = steps_ - 1;
+    }
+    else
+    {
+        uint64_t end = steps_;
+        for (size_t k = snapshots_.size(); k-- > 0 && !found && !stop;)
+        {
+            uint64_t begin = snapshots_[k].state.steps;
+            if (begin >= end)
+                continue;
+            rewind(k);
+            while (steps_ < end)
+            {
+                if (reverse_stop_here())
+                    found = steps_;
+                if ((stop = poll_stop()))
+                    break;
+                step_instruction();
+            }
+            end = begin;
+        }
+    }
+
+    const char *reason = "step";
+    if (stop)
+        reason = *stop;
+    else if (found)
+    {
+        size_t k = snapshots_.size() - 1;
+        while (k > 0 && snapshots_[k].state.steps > *found)
+            --k;
+        rewind(k);
+        stop = replay_to(*found);
+        uint16_t pc = z80ex_get_reg(cpu_, regPC);
+        if (stop)
+            reason = *stop;
+        else if ((bp_map_[pc] & ~bp_temp) && breakpoint_hit(pc))
+            reason = "breakpoint";
+    }
+    else
+    {
+        rewind(0);
+        description = "Reached the start of the recorded history";
+    }
+
+    replaying_ = false;
+    instruments_ = instruments;
+    return reason;
+}
@@ -49,14 +49,13 @@ int main()
         dap::dap dispatcher;
         dbg debug_instance;
 
-        // Wire up event sending: dbg -> socket.
-        auto event_sender = [&](const std::string &event_json)
-        {
-            out << "Content-Length: " << event_json.size() << "\r\n\r\n"
-                << event_json << std::flush;
-        };
-        dispatcher.set_event_sender(event_sender);
-        debug_instance.set_event_sender(event_sender);
+        // Wire up event sending: dbg -> dispatcher -> socket. The
+        // dispatcher serializes events with responses, which matters once
+        // the execution thread reports stops on its own.
+        debug_instance.set_event_sender([&](const std::string &event_json)
+                                        { dispatcher.send_event(event_json); });
+        debug_instance.set_try_event_sender([&](const std::string &event_json)
+                                            { return dispatcher.try_send_event(event_json); });
 
         // Register all handler objects (chain of responsibility).
         debug_instance.register_handlers(dispatcher);
@@ -0,0 +1,89 @@
+// memory_map.cpp
+// Paged, bank-switched memory model for the emulated Z80.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <memory_map.h>
+
+#include <algorithm>
+
+memory_map::memory_map()
+{
+    configure(1);
+}
+
+void memory_map::configure(unsigned banks)
+{
+    banks_ = std::clamp(banks, 1u, 256u);
+    store_.assign(static_cast<size_t>(banks_) << 16, 0);
+    watched_pages_.assign(store_.size() >> page_bits, 0);
+    windows_.clear();
+    rom_.fill(false);
+    for (unsigned page = 0; page < page_count; ++page)
+        map_page(page, page << page_bits);
+}
+
+void memory_map::set_rom(unsigned first_page, unsigned pages)
+{
+    for (unsigned page = first_page; page < first_page + pages && page < page_count; ++page)
+    {
+        rom_[page] = true;
+        map_page(page, page_base_[page]);
+    }
+}
+
+int memory_map::add_window(unsigned first_page, unsigned pages)
+{
+    if (pages == 0 || first_page + pages > page_count)
+        return -1;
+    for (const auto &w : windows_)
+    {
+        if (first_page < w.first_page + w.pages && w.first_page < first_page + pages)
+            return -1;
+    }
+    windows_.push_back({first_page, pages, 0});
+    return static_cast<int>(windows_.size() - 1);
+}
+
+void memory_map::clear()
+{
+    std::fill(store_.begin(), store_.end(), 0);
+    for (size_t i = 0; i < windows_.size(); ++i)
+        select_bank(i, 0);
+}
+
+void memory_map::select_bank(size_t window, uint8_t bank)
+{
+    // Bank numbers beyond the physical store wrap, as they would on a
+    // board with fewer banks fitted than the register can address.
+    auto &w = windows_[window];
+    w.bank = static_cast<uint8_t>(bank % banks_);
+    uint32_t bank_base = static_cast<uint32_t>(w.bank) << 16;
+    for (unsigned page = w.first_page; page < w.first_page + w.pages; ++page)
+        map_page(page, bank_base | (page << page_bits));
+}
+
+void memory_map::watch(uint32_t address, uint8_t flags)
+{
+    uint32_t page = wrap(address) >> page_bits;
+    watched_pages_[page] |= flags;
+    for (unsigned p = 0; p < page_count; ++p)
+    {
+        if ((page_base_[p] >> page_bits) == page)
+            watch_[p] = watched_pages_[page];
+    }
+}
+
+void memory_map::clear_watches()
+{
+    std::fill(watched_pages_.begin(), watched_pages_.end(), 0);
+    watch_.fill(0);
+}
+
+void memory_map::map_page(unsigned page, uint32_t base)
+{
+    page_base_[page] = base;
+    watch_[page] = watched_pages_[base >> page_bits];
+    read_pages_[page] = store_.data() + base;
+    write_pages_[page] = rom_[page] ? discard_.data() : store_.data() + base;
+}
@@ -0,0 +1,129 @@
+// memory_map.h
+// Paged, bank-switched memory model for the emulated Z80.
+//
+// The 64K CPU address space is split into 4K pages, each pointing into a
+// physical store that may be larger than 64K. Reads and writes index the
+// page tables directly, so switching a bank only rewrites the pointers of
+// the pages in its window.
+//
+// Physical addresses follow the SDCC convention for banked code: bank n
+// of a window holds CPU address a at (n << 16) | a, which is what the
+// linker writes to IHX extended linear address records, MAP symbols and
+// CDB line records. Bank 0 of every window, and all unbanked memory, is
+// therefore addressed by its plain CPU address.
+//
+// Windows are switched through bank_register devices on the I/O bus.
+//
+// Data breakpoints flag the physical pages they watch. The flags are
+// mapped through the page tables like the data, so the memory callbacks
+// test one byte per access and only look further on watched pages.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <platform/io_bus.h>
+
+class memory_map
+{
+public:
+    static constexpr unsigned page_bits = 12;
+    static constexpr uint32_t page_size = 1u << page_bits;
+    static constexpr uint32_t page_mask = page_size - 1;
+    static constexpr unsigned page_count = 0x10000 >> page_bits;
+
+    // Page watch flags.
+    static constexpr uint8_t watch_read = 0x01;
+    static constexpr uint8_t watch_write = 0x02;
+
+    // CPU pages [first_page, first_page + pages) show the selected bank.
+    struct bank_window {
+        unsigned first_page = 0;
+        unsigned pages = 0;
+        uint8_t bank = 0;
+    };
+
+    // Flat 64K of RAM, identity mapped.
+    memory_map();
+    memory_map(const memory_map &) = delete;
+    memory_map &operator=(const memory_map &) = delete;
+
+    // Start over with `banks` 64K banks of physical memory, all RAM, no
+    // bank windows and every window at bank 0. Contents are cleared.
+    void configure(unsigned banks);
+    // Writes to CPU pages [first_page, first_page + pages) are ignored.
+    void set_rom(unsigned first_page, unsigned pages);
+    // Add a bank window and return its index, or -1 if it overlaps
+    // another window or falls outside the address space.
+    int add_window(unsigned first_page, unsigned pages);
+    // Zero the physical store and select bank 0 in every window.
+    void clear();
+
+    // CPU view.
+    uint8_t read(uint16_t addr) const
+    {
+        return read_pages_[addr >> page_bits][addr & page_mask];
+    }
+    void write(uint16_t addr, uint8_t value)
+    {
+        write_pages_[addr >> page_bits][addr & page_mask] = value;
+    }
+    uint32_t physical(uint16_t addr) const
+    {
+        return page_base_[addr >> page_bits] | (addr & page_mask);
+    }
+
+    // Watch flags of the page holding CPU address `addr`.
+    uint8_t watched(uint16_t addr) const { return watch_[addr >> page_bits]; }
+    // Add `flags` to the physical page holding `address`.
+    void watch(uint32_t address, uint8_t flags);
+    void clear_watches();
+
+    void select_bank(size_t window, uint8_t bank);
+    const std::vector<bank_window> &windows() const { return windows_; }
+    bool banked() const { return !windows_.empty(); }
+    unsigned banks() const { return banks_; }
+
+    // Physical store, indexed by physical address.
+    std::vector<uint8_t> &store() { return store_; }
+    const std::vector<uint8_t> &store() const { return store_; }
+    // Physical address for a linker address: addresses beyond the store
+    // wrap, like a program linked for more banks than the machine has.
+    uint32_t wrap(uint32_t address) const
+    {
+        return address % static_cast<uint32_t>(store_.size());
+    }
+
+private:
+    void map_page(unsigned page, uint32_t base);
+
+    std::vector<uint8_t> store_;
+    unsigned banks_ = 1;
+    std::array<const uint8_t *, page_count> read_pages_{};
+    std::array<uint8_t *, page_count> write_pages_{};
+    std::array<uint32_t, page_count> page_base_{};
+    std::array<bool, page_count> rom_{};
+    std::array<uint8_t, page_count> watch_{};
+    std::vector<uint8_t> watched_pages_;        // Per physical page.
+    std::vector<bank_window> windows_;
+    std::array<uint8_t, page_size> discard_{};  // Sink for ROM writes.
+};
+
+// Write-only bank select register of one window.
+class bank_register : public platform::io_device
+{
+public:
+    bank_register(memory_map &memory, size_t window)
+        : memory_(memory), window_(window) {}
+
+    uint8_t read(uint8_t) override { return 0xFF; }
+    void write(uint8_t, uint8_t value) override { memory_.select_bank(window_, value); }
+
+private:
+    memory_map &memory_;
+    size_t window_;
+};
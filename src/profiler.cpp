@@ -0,0 +1,394 @@
+// profiler.cpp
+// Aggregation and export of the execution profiles.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <profiler.h>
+#include <dbg.h>
+
+#include <map>
+
+namespace {
+
+using row = profile_summary::row;
+
+void add(row &r, uint32_t address, const exec_profile::counter &c)
+{
+    if (!r.count || address < r.address)
+        r.address = address;
+    r.count += c.count;
+    r.tstates += c.tstates;
+}
+
+template <typename Map>
+std::vector<row> sorted_rows(Map &groups)
+{
+    std::vector<row> rows;
+    rows.reserve(groups.size());
+    for (auto &[key, r] : groups)
+        rows.push_back(std::move(r));
+    std::stable_sort(rows.begin(), rows.end(), [](const row &a, const row &b)
+        { return a.tstates > b.tstates; });
+    return rows;
+}
+
+std::string hex_address(uint32_t address)
+{
+    std::ostringstream oss;
+    oss << "0x" << std::uppercase << std::hex << std::setfill('0')
+        << std::setw(address > 0xFFFF ? 6 : 4) << address;
+    return oss.str();
+}
+
+// CSV field, quoted when it needs to be.
+std::string csv_field(const std::string &s)
+{
+    if (s.find_first_of(",\"\n") == std::string::npos)
+        return s;
+    std::string quoted = "\"";
+    for (char c : s)
+    {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+// Display name of the function at `address`: its CDB function, else the
+// MAP label at or below it, else "" (no debug info at all).
+std::string function_name(const dbg &ctx, uint32_t address)
+{
+    if (const auto *fn = ctx.lookup_function(address))
+        return fn->name;
+    if (const auto *sym = ctx.lookup_symbol_base(address))
+        return sym->name;
+    return {};
+}
+
+// Call graph node label: the function name, or the address.
+std::string node_name(const dbg &ctx, uint32_t address)
+{
+    auto name = function_name(ctx, address);
+    return name.empty() ? hex_address(address) : name;
+}
+
+} // namespace
+
+void call_graph::enter(uint32_t address)
+{
+    uint32_t parent = current();
+    uint64_t key = static_cast<uint64_t>(parent) << 32 | address;
+    auto it = children_.find(key);
+    if (it == children_.end())
+    {
+        // Out of nodes: new paths stay charged to the caller.
+        if (nodes_.size() >= max_nodes)
+        {
+            path_.push_back(parent);
+            return;
+        }
+        auto index = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back({address, parent, 0, 0});
+        it = children_.emplace(key, index).first;
+    }
+    ++nodes_[it->second].calls;
+    path_.push_back(it->second);
+}
+
+profile_summary summarize_profile(const dbg &ctx, const exec_profile &profile)
+{
+    profile_summary summary;
+    std::map<std::string, row> symbols;
+    std::map<std::pair<uint16_t, int>, row> lines;
+
+    const auto &counters = profile.counters();
+    for (uint32_t address = 0; address < counters.size(); ++address)
+    {
+        const auto &c = counters[address];
+        if (!c.count)
+            continue;
+        summary.count += c.count;
+        summary.tstates += c.tstates;
+
+        row at;
+        at.address = address;
+        at.count = c.count;
+        at.tstates = c.tstates;
+
+        // Functions cover their local labels; MAP symbols are the
+        // fallback for code without CDB records (assembler, libraries).
+        at.name = function_name(ctx, address);
+        auto &by_symbol = symbols[at.name];
+        by_symbol.name = at.name;
+        add(by_symbol, address, c);
+
+        if (auto loc = ctx.lookup_source(address))
+        {
+            at.file = std::string(loc->file);
+            at.line = loc->line;
+            auto &by_line = lines[{loc->file_id, loc->line}];
+            by_line.file = at.file;
+            by_line.line = at.line;
+            add(by_line, address, c);
+        }
+        summary.addresses.push_back(std::move(at));
+    }
+
+    summary.symbols = sorted_rows(symbols);
+    summary.lines = sorted_rows(lines);
+    std::stable_sort(summary.addresses.begin(), summary.addresses.end(),
+        [](const row &a, const row &b) { return a.tstates > b.tstates; });
+    return summary;
+}
+
+void summarize_call_graph(const dbg &ctx, const std::vector<call_graph::node> &nodes,
+                          profile_summary &summary)
+{
+    // Children are created after their parents, so a backward pass sums
+    // every subtree.
+    std::vector<uint64_t> total(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0;)
+    {
+        total[i] += nodes[i].tstates;
+        if (i != call_graph::root)
+            total[nodes[i].parent] += total[i];
+    }
+
+    std::vector<std::string> names(nodes.size());
+    for (size_t i = 1; i < nodes.size(); ++i)
+        names[i] = node_name(ctx, nodes[i].address);
+
+    // Walk the tree depth first, counting how often each function is on
+    // the current path: only its outermost activation adds inclusive time.
+    std::vector<std::vector<uint32_t>> children(nodes.size());
+    for (uint32_t i = 1; i < nodes.size(); ++i)
+        children[nodes[i].parent].push_back(i);
+
+    std::map<std::string, row> functions;
+    std::unordered_map<std::string, unsigned> active;
+    struct visit {
+        uint32_t node;
+        bool leaving;
+    };
+    std::vector<visit> pending;
+    for (uint32_t child : children[call_graph::root])
+        pending.push_back({child, false});
+    while (!pending.empty())
+    {
+        auto [index, leaving] = pending.back();
+        pending.pop_back();
+        const auto &name = names[index];
+        if (leaving)
+        {
+            --active[name];
+            continue;
+        }
+
+        auto &fn = functions[name];
+        fn.name = name;
+        if (!fn.count || nodes[index].address < fn.address)
+            fn.address = nodes[index].address;
+        fn.count += nodes[index].calls;
+        fn.tstates += nodes[index].tstates;
+        if (active[name]++ == 0)
+            fn.inclusive += total[index];
+
+        pending.push_back({index, true});
+        for (uint32_t child : children[index])
+            pending.push_back({child, false});
+    }
+
+    summary.functions = sorted_rows(functions);
+    std::stable_sort(summary.functions.begin(), summary.functions.end(),
+        [](const row &a, const row &b) { return a.inclusive > b.inclusive; });
+}
+
+std::string folded_stacks(const dbg &ctx, const std::vector<call_graph::node> &nodes)
+{
+    std::vector<std::string> names(nodes.size());
+    for (size_t i = 1; i < nodes.size(); ++i)
+        names[i] = node_name(ctx, nodes[i].address);
+
+    std::ostringstream out;
+    if (!nodes.empty() && nodes[call_graph::root].tstates)
+        out << "[root] " << nodes[call_graph::root].tstates << '\n';
+    std::vector<uint32_t> chain;
+    for (uint32_t i = 1; i < nodes.size(); ++i)
+    {
+        if (!nodes[i].tstates)
+            continue;
+        chain.clear();
+        for (uint32_t n = i; n != call_graph::root; n = nodes[n].parent)
+            chain.push_back(n);
+        for (size_t j = chain.size(); j-- > 0;)
+            out << names[chain[j]] << (j ? ';' : ' ');
+        out << nodes[i].tstates << '\n';
+    }
+    return out.str();
+}
+
+std::vector<pc_sampler::sample> pc_sampler::samples() const
+{
+    std::vector<sample> result;
+    size_t kept = static_cast<size_t>(std::min<uint64_t>(taken_, ring_.size()));
+    result.reserve(kept);
+    size_t first = taken_ > ring_.size() ? next_ : 0;
+    for (size_t i = 0; i < kept; ++i)
+        result.push_back(ring_[(first + i) % ring_.size()]);
+    return result;
+}
+
+profile_summary summarize_samples(const dbg &ctx,
+                                  const std::vector<pc_sampler::sample> &samples,
+                                  uint32_t interval)
+{
+    profile_summary summary;
+    std::map<std::string, row> symbols;
+    std::map<std::pair<uint16_t, int>, row> lines;
+    std::map<uint32_t, row> addresses;
+    std::map<std::string, row> functions;
+    const exec_profile::counter one = {1, interval};
+
+    std::vector<std::string> stack;
+    for (const auto &s : samples)
+    {
+        if (!s.depth)
+            continue;
+        uint32_t pc = s.frames[0];
+        summary.count += 1;
+        summary.tstates += interval;
+
+        auto name = function_name(ctx, pc);
+        auto &by_symbol = symbols[name];
+        by_symbol.name = name;
+        add(by_symbol, pc, one);
+
+        auto &at = addresses[pc];
+        at.name = name;
+        if (auto loc = ctx.lookup_source(pc))
+        {
+            at.file = std::string(loc->file);
+            at.line = loc->line;
+            auto &by_line = lines[{loc->file_id, loc->line}];
+            by_line.file = at.file;
+            by_line.line = at.line;
+            add(by_line, pc, one);
+        }
+        add(at, pc, one);
+
+        // Inclusive time once per function on the sampled stack; callers
+        // are named after the function making the call.
+        stack.clear();
+        for (uint8_t i = 0; i < s.depth; ++i)
+        {
+            auto frame = node_name(ctx, s.frames[i]);
+            if (std::find(stack.begin(), stack.end(), frame) != stack.end())
+                continue;
+            auto &fn = functions[frame];
+            fn.name = frame;
+            if (!fn.count || s.frames[i] < fn.address)
+                fn.address = s.frames[i];
+            fn.count += 1;
+            fn.inclusive += interval;
+            if (i == 0)
+                fn.tstates += interval;
+            stack.push_back(std::move(frame));
+        }
+    }
+
+    summary.symbols = sorted_rows(symbols);
+    summary.lines = sorted_rows(lines);
+    summary.addresses = sorted_rows(addresses);
+    summary.functions = sorted_rows(functions);
+    std::stable_sort(summary.functions.begin(), summary.functions.end(),
+        [](const row &a, const row &b) { return a.inclusive > b.inclusive; });
+    return summary;
+}
+
+std::string folded_stacks(const dbg &ctx,
+                          const std::vector<pc_sampler::sample> &samples,
+                          uint32_t interval)
+{
+    std::map<std::string, uint64_t> stacks;
+    std::string path;
+    for (const auto &s : samples)
+    {
+        if (!s.depth)
+            continue;
+        path.clear();
+        for (size_t i = s.depth; i-- > 0;)
+        {
+            path += node_name(ctx, s.frames[i]);
+            if (i)
+                path += ';';
+        }
+        stacks[path] += interval;
+    }
+
+    std::ostringstream out;
+    for (const auto &[stack, tstates] : stacks)
+        out << stack << ' ' << tstates << '\n';
+    return out.str();
+}
+
+nlohmann::json profile_json(const profile_summary &summary, size_t limit)
+{
+    auto table = [limit](const std::vector<row> &rows)
+    {
+        auto result = nlohmann::json::array();
+        size_t n = limit ? std::min(limit, rows.size()) : rows.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            const auto &r = rows[i];
+            nlohmann::json item = {{"address", hex_address(r.address)},
+                                   {"count", r.count},
+                                   {"tstates", r.tstates}};
+            if (!r.name.empty())
+                item["name"] = r.name;
+            if (r.line)
+            {
+                item["file"] = r.file;
+                item["line"] = r.line;
+            }
+            if (r.inclusive)
+                item["inclusive"] = r.inclusive;
+            result.push_back(std::move(item));
+        }
+        return result;
+    };
+
+    nlohmann::json report = {{"instructions", summary.count},
+                             {"tstates", summary.tstates},
+                             {"symbols", table(summary.symbols)},
+                             {"lines", table(summary.lines)},
+                             {"addresses", table(summary.addresses)}};
+    if (!summary.functions.empty())
+        report["functions"] = table(summary.functions);
+    return report;
+}
+
+std::string profile_csv(const profile_summary &summary)
+{
+    std::ostringstream out;
+    out << "kind,address,name,file,line,count,tstates,inclusive\n";
+    auto table = [&out](const char *kind, const std::vector<row> &rows)
+    {
+        for (const auto &r : rows)
+        {
+            out << kind << ',' << hex_address(r.address) << ','
+                << csv_field(r.name) << ',' << csv_field(r.file) << ',';
+            if (r.line)
+                out << r.line;
+            out << ',' << r.count << ',' << r.tstates << ',';
+            if (r.inclusive)
+                out << r.inclusive;
+            out << '\n';
+        }
+    };
+    table("symbol", summary.symbols);
+    table("line", summary.lines);
+    table("address", summary.addresses);
+    table("function", summary.functions);
+    return out.str();
+}
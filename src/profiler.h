@@ -0,0 +1,214 @@
+// profiler.h
+// Execution profiles: instruction and T-state counts per address, and a
+// call graph.
+//
+// While profiling is on, the CPU loop adds every instruction it executes,
+// and its T-states, to a flat table indexed by the physical address of the
+// instruction (one slot per byte of the physical store, so 64K slots on an
+// unbanked machine). Nothing is looked up while the CPU runs; reports
+// aggregate the table by MAP symbol and CDB source line when asked for.
+// With profiling off the CPU loop doesn't touch the table at all.
+//
+// The call graph profiler additionally charges every instruction to the
+// chain of calls it ran under (see call_graph), for inclusive and
+// exclusive time per function and flame graphs. For long runs the PC
+// sampler (see pc_sampler) gives the same reports approximately, at a
+// small fraction of the cost.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+class dbg;
+
+class exec_profile
+{
+public:
+    struct counter {
+        uint64_t count = 0;     // Instructions executed at the address.
+        uint64_t tstates = 0;
+    };
+
+    // One counter per physical address; zeroes the table if its size
+    // changes.
+    void resize(size_t addresses)
+    {
+        if (counters_.size() != addresses)
+            counters_.assign(addresses, counter{});
+    }
+    void clear() { counters_.assign(counters_.size(), counter{}); }
+
+    void record(uint32_t address, unsigned tstates)
+    {
+        auto &c = counters_[address];
+        ++c.count;
+        c.tstates += tstates;
+    }
+
+    const std::vector<counter> &counters() const { return counters_; }
+
+private:
+    std::vector<counter> counters_;
+};
+
+// Calling context tree for the call graph profiler: one node per distinct
+// chain of calls, keyed by call target, each holding the T-states spent in
+// it outside its callees. The CPU loop enters a node when it pushes a
+// shadow call stack frame (CALL, RST, accepted interrupt) and leaves it
+// when the frame is dropped, so the tree follows the same SP rules as
+// stack traces: a frame goes when SP rises above its return address,
+// whether through RET or a stack reset. Depth is bounded by the shadow
+// stack and the node count by max_nodes (deeper new paths are charged to
+// the caller).
+class call_graph
+{
+public:
+    static constexpr uint32_t root = 0;     // Time outside any call.
+    static constexpr size_t max_nodes = 0x10000;
+
+    struct node {
+        uint32_t address = 0;   // Physical call target.
+        uint32_t parent = root;
+        uint64_t calls = 0;
+        uint64_t tstates = 0;   // Exclusive.
+    };
+
+    call_graph() { clear(); }
+
+    void clear()
+    {
+        nodes_.assign(1, node{});
+        path_.clear();
+        children_.clear();
+    }
+
+    void record(unsigned tstates) { nodes_[current()].tstates += tstates; }
+    void enter(uint32_t address);
+    void leave()
+    {
+        if (!path_.empty())
+            path_.pop_back();
+    }
+    // The shadow stack forgot its outermost frame.
+    void drop_outermost()
+    {
+        if (!path_.empty())
+            path_.erase(path_.begin());
+    }
+    // Forget the current chain of calls (the shadow stack was reset).
+    void reset_path() { path_.clear(); }
+    size_t depth() const { return path_.size(); }
+
+    const std::vector<node> &nodes() const { return nodes_; }
+
+private:
+    uint32_t current() const { return path_.empty() ? root : path_.back(); }
+
+    std::vector<node> nodes_;
+    std::vector<uint32_t> path_;
+    std::unordered_map<uint64_t, uint32_t> children_;  // parent:address
+};
+
+// Statistical profiler: every `interval` T-states a scheduler timer (see
+// platform/scheduler.h) records the PC and the innermost shadow call stack
+// frames into a fixed ring buffer. The CPU loop already compares the clock
+// with the next event after every instruction, so sampling adds nothing
+// per instruction; the cost is one sample per interval.
+class pc_sampler
+{
+public:
+    static constexpr size_t stack_depth = 8;
+
+    // frames[0] is the physical PC, then the call instructions of up to
+    // stack_depth - 1 callers, innermost first.
+    struct sample {
+        std::array<uint32_t, stack_depth> frames{};
+        uint8_t depth = 0;
+    };
+
+    // Keep the last `capacity` samples, taken `interval` T-states apart;
+    // clears the buffer.
+    void configure(uint32_t interval, size_t capacity)
+    {
+        interval_ = interval;
+        ring_.assign(capacity ? capacity : 1, sample{});
+        clear();
+    }
+    void clear()
+    {
+        next_ = 0;
+        taken_ = 0;
+    }
+
+    void record(const sample &s)
+    {
+        ring_[next_] = s;
+        if (++next_ == ring_.size())
+            next_ = 0;
+        ++taken_;
+    }
+
+    // Samples still in the buffer, oldest first.
+    std::vector<sample> samples() const;
+    uint64_t taken() const { return taken_; }
+    size_t capacity() const { return ring_.size(); }
+    uint32_t interval() const { return interval_; }
+
+private:
+    uint32_t interval_ = 1;
+    std::vector<sample> ring_ = std::vector<sample>(1);
+    size_t next_ = 0;
+    uint64_t taken_ = 0;
+};
+
+// A profile aggregated for reporting. Rows are sorted by T-states, most
+// expensive first.
+struct profile_summary {
+    struct row {
+        std::string name;       // Function or MAP symbol ("" for lines).
+        std::string file;       // Source file (lines only).
+        int line = 0;
+        uint32_t address = 0;   // Physical; lowest address of the group.
+        uint64_t count = 0;     // Calls, for functions.
+        uint64_t tstates = 0;   // Exclusive, for functions.
+        uint64_t inclusive = 0; // Functions only.
+    };
+    uint64_t count = 0;
+    uint64_t tstates = 0;
+    std::vector<row> symbols;   // By CDB function, else MAP symbol.
+    std::vector<row> lines;     // By CDB (or MAP C$) source line.
+    std::vector<row> addresses; // Every address executed.
+    std::vector<row> functions; // Call graph, by inclusive T-states.
+};
+
+profile_summary summarize_profile(const dbg &ctx, const exec_profile &profile);
+// Fill in summary.functions from a call graph. Recursive calls count
+// towards a function's inclusive time once.
+void summarize_call_graph(const dbg &ctx, const std::vector<call_graph::node> &nodes,
+                          profile_summary &summary);
+// Brendan Gregg's folded stack format, one "caller;callee T-states" line
+// per calling context, for flamegraph.pl and friends.
+std::string folded_stacks(const dbg &ctx, const std::vector<call_graph::node> &nodes);
+
+// Aggregate PC samples taken every `interval` T-states: counts are
+// samples, T-states are estimated as samples * interval, and functions
+// get inclusive time from the sampled call stacks.
+profile_summary summarize_samples(const dbg &ctx,
+                                  const std::vector<pc_sampler::sample> &samples,
+                                  uint32_t interval);
+std::string folded_stacks(const dbg &ctx,
+                          const std::vector<pc_sampler::sample> &samples,
+                          uint32_t interval);
+
+// Report formats. `limit` caps the rows of each table (0 for all).
+nlohmann::json profile_json(const profile_summary &summary, size_t limit);
+// One table with a `kind` column: symbol, line, address or function.
+std::string profile_csv(const profile_summary &summary);
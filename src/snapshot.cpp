@@ -0,0 +1,201 @@
+// snapshot.cpp
+// Machine snapshots that can be saved, shared and restored.
+//
+// This file implements the snapshot functions of the `dbg` class. A
+// snapshot is a machine_state (see history.cpp) followed by the memory,
+// stored as the runs of bytes that differ from the image loaded at launch.
+// Programs touch a small part of memory, so a snapshot of a 64K machine
+// is usually a few kilobytes, and restoring one is a copy of the image
+// plus the runs. The image itself isn't stored: a header hash of it makes
+// sure a snapshot only goes back on top of the image it was taken from.
+//
+// Layout (native byte order, the blob is read back by the same build):
+//   magic "MUDAPSNP", version, image hash, store size,
+//   steps, T-states, registers, bank count and banks, device state size
+//   and bytes, call stack depth and frames,
+//   run count, then per run: offset, length and bytes.
+//
+// Copyright 2025 Tomaz Stih. All rights reserved.
+// MIT License.
+#include <dbg.h>
+#include <platform/state.h>
+
+namespace {
+
+constexpr std::array<char, 8> magic = {'M', 'U', 'D', 'A', 'P', 'S', 'N', 'P'};
+constexpr uint32_t version = 1;
+
+// Runs closer than this are stored as one: a run header costs 8 bytes.
+constexpr uint32_t run_gap = 8;
+
+// FNV-1a.
+uint64_t image_hash(const std::vector<uint8_t> &image)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (uint8_t b : image)
+        hash = (hash ^ b) * 0x100000001B3ull;
+    return hash;
+}
+
+// A vector preceded by its element count.
+template <typename T>
+void put_vector(platform::state_writer &out, const std::vector<T> &v)
+{
+    out.put(static_cast<uint32_t>(v.size()));
+    out.bytes(v.data(), v.size() * sizeof(T));
+}
+
+template <typename T>
+bool get_vector(platform::state_reader &in, std::vector<T> &v)
+{
+    auto count = in.get<uint32_t>();
+    if (count > in.remaining() / sizeof(T))
+        return false;
+    v.resize(count);
+    in.bytes(v.data(), v.size() * sizeof(T));
+    return in.ok();
+}
+
+} // namespace
+
+std::vector<uint8_t> dbg::save_snapshot() const
+{
+    machine_state state;
+    capture_state(state);
+
+    std::vector<uint8_t> blob;
+    platform::state_writer out(blob);
+    out.put(magic);
+    out.put(version);
+    out.put(base_hash_);
+    const auto &store = memory_.store();
+    out.put(static_cast<uint32_t>(store.size()));
+
+    out.put(state.steps);
+    out.put(state.tstates);
+    out.put(state.registers);
+    put_vector(out, state.banks);
+    put_vector(out, state.devices);
+    put_vector(out, state.call_stack);
+
+    // Differences from the loaded image (zeroes if there is none).
+    auto base = [this](size_t i) -> uint8_t
+        { return i < base_image_.size() ? base_image_[i] : 0; };
+    std::vector<std::pair<uint32_t, uint32_t>> runs;
+    const auto size = static_cast<uint32_t>(store.size());
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        if (store[i] == base(i))
+            continue;
+        if (!runs.empty() && i - (runs.back().first + runs.back().second) < run_gap)
+            runs.back().second = i + 1 - runs.back().first;
+        else
+            runs.push_back({i, 1});
+    }
+    out.put(static_cast<uint32_t>(runs.size()));
+    for (const auto &[offset, length] : runs)
+    {
+        out.put(offset);
+        out.put(length);
+        out.bytes(store.data() + offset, length);
+    }
+    return blob;
+}
+
+bool dbg::load_snapshot(const std::vector<uint8_t> &blob, std::string &error)
+{
+    platform::state_reader in(blob);
+    auto &store = memory_.store();
+    if (in.get<std::array<char, 8>>() != magic || in.get<uint32_t>() != version)
+    {
+        error = "Not a snapshot, or from another version";
+        return false;
+    }
+    if (in.get<uint64_t>() != base_hash_ || in.get<uint32_t>() != store.size())
+    {
+        error = "Snapshot was taken from another program image or machine";
+        return false;
+    }
+
+    machine_state state;
+    state.steps = in.get<uint64_t>();
+    state.tstates = in.get<uint64_t>();
+    state.registers = in.get<decltype(state.registers)>();
+    if (!get_vector(in, state.banks) || !get_vector(in, state.devices) ||
+        !get_vector(in, state.call_stack))
+    {
+        error = "Snapshot is truncated";
+        return false;
+    }
+
+    // Check every run before touching anything.
+    struct run {
+        uint32_t offset;
+        uint32_t length;
+        const uint8_t *data;
+    };
+    std::vector<run> runs;
+    for (auto count = in.get<uint32_t>(); count && in.ok(); --count)
+    {
+        auto offset = in.get<uint32_t>();
+        auto length = in.get<uint32_t>();
+        const uint8_t *data = in.skip(length);
+        if (!data || offset > store.size() || length > store.size() - offset)
+        {
+            error = "Snapshot memory is truncated or out of range";
+            return false;
+        }
+        runs.push_back({offset, length, data});
+    }
+    if (!in.ok() || in.remaining())
+    {
+        error = "Snapshot is truncated";
+        return false;
+    }
+    if (!restore_state(state))
+    {
+        error = "Snapshot devices don't match the machine";
+        return false;
+    }
+
+    if (base_image_.size() == store.size())
+        std::memcpy(store.data(), base_image_.data(), store.size());
+    else
+        std::fill(store.begin(), store.end(), 0);
+    for (const auto &r : runs)
+        std::memcpy(store.data() + r.offset, r.data, r.length);
+
+    // The reverse execution history leads somewhere else now.
+    restart_recording();
+    return true;
+}
+
+void dbg::set_restart_point()
+{
+    base_image_ = memory_.store();
+    base_hash_ = image_hash(base_image_);
+    restart_point_ = save_snapshot();
+}
+
+bool dbg::restart(std::string &error)
+{
+    if (restart_point_.empty())
+    {
+        error = "Nothing has been launched";
+        return false;
+    }
+
+    // Nothing has been hit at the entry point. The counts are cleared
+    // first, so that the history restarted by load_snapshot starts at zero.
+    std::vector<uint64_t> hits;
+    for (auto &bc : hit_counted_)
+    {
+        hits.push_back(bc->hits);
+        bc->hits = 0;
+    }
+    if (load_snapshot(restart_point_, error))
+        return true;
+    for (size_t i = 0; i < hits.size(); ++i)
+        hit_counted_[i]->hits = hits[i];
+    return false;
+}
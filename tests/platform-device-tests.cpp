@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include <platform/io_bus.h>
+#include <platform/sio.h>
+#include <platform/ctc.h>
+#include <platform/scheduler.h>
+#include <platform/state.h>
+#include <platform/interrupts.h>
+#include <platform/platform.h>
+#include <bitset>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace platform;
+
+TEST(IoBusTest, DispatchesPortRanges) {
+    io_bus bus;
+    std::string out;
+    sio console([&](uint8_t c) { out += static_cast<char>(c); });
+
+    ASSERT_TRUE(bus.attach(0x80, sio::port_count, console));
+    EXPECT_FALSE(bus.attach(0x81, 1, console)) << "Port 0x81 is taken";
+    EXPECT_FALSE(bus.attach(0xFF, 2, console)) << "Range runs past port 0xFF";
+
+    // Unclaimed ports read as open bus; the high byte is not decoded.
+    EXPECT_EQ(bus.read(0x10), 0xFF);
+    bus.write(0x1280, 'h');
+    bus.write(0x0080, 'i');
+    EXPECT_EQ(out, "hi");
+
+    bus.detach_all();
+    bus.write(0x80, '!');
+    EXPECT_EQ(out, "hi");
+    EXPECT_TRUE(bus.attach(0x81, 1, console));
+}
+
+TEST(SioTest, StatusAndInput) {
+    sio console(nullptr);
+
+    // RR0: transmit buffer empty, nothing received.
+    EXPECT_EQ(console.read(1), 0x04);
+    console.receive("ok");
+    EXPECT_EQ(console.read(1), 0x05);
+    EXPECT_EQ(console.read(0), 'o');
+    EXPECT_EQ(console.read(0), 'k');
+    EXPECT_EQ(console.read(1), 0x04);
+
+    // WR2 holds the vector, read back through RR2.
+    console.write(1, 0x02);
+    console.write(1, 0x40);
+    console.write(1, 0x02);
+    EXPECT_EQ(console.read(1), 0x40);
+    EXPECT_EQ(console.read(1), 0x04) << "Pointer returns to RR0";
+}
+
+TEST(SchedulerTest, FiresInOrderAndHonoursCancel) {
+    scheduler clock;
+    std::string fired;
+    scheduler::timer a(clock, [&](uint64_t at) { fired += "a" + std::to_string(at) + " "; });
+    scheduler::timer b(clock, [&](uint64_t at) { fired += "b" + std::to_string(at) + " "; });
+    scheduler::timer c(clock, [&](uint64_t) { fired += "c "; });
+
+    EXPECT_FALSE(clock.due()) << "Nothing scheduled";
+    a.arm(100);
+    b.arm(50);
+    c.arm(70);
+    c.cancel();
+    a.arm(120);     // Re-arming replaces the pending event.
+
+    clock.advance(60);
+    ASSERT_TRUE(clock.due());
+    clock.run_due();
+    EXPECT_EQ(fired, "b50 ");
+    EXPECT_FALSE(b.armed());
+
+    clock.advance(100);
+    clock.run_due();
+    EXPECT_EQ(fired, "b50 a120 ");
+    EXPECT_FALSE(clock.due());
+}
+
+TEST(SchedulerTest, PeriodicTimerDoesNotDrift) {
+    scheduler clock;
+    std::vector<uint64_t> ticks;
+    std::optional<scheduler::timer> t;
+    t.emplace(clock, [&](uint64_t at) { ticks.push_back(at); t->arm(at + 10); });
+    t->arm(10);
+
+    // Instructions overshoot the due time; events still land on the grid.
+    for (int i = 0; i < 10; ++i)
+    {
+        clock.advance(7);
+        if (clock.due())
+            clock.run_due();
+    }
+    EXPECT_EQ(ticks, (std::vector<uint64_t>{10, 20, 30, 40, 50, 60, 70}));
+}
+
+TEST(InterruptChainTest, DaisyChainPriority) {
+    interrupt_chain chain;
+    unsigned high = chain.add_source();
+    unsigned low = chain.add_source();
+
+    EXPECT_FALSE(chain.pending());
+    EXPECT_EQ(chain.vector(), 0xFF);
+    chain.request(low, 0x12);
+    chain.request(high, 0x10);
+    EXPECT_EQ(chain.vector(), 0x10);
+    chain.acknowledge();
+    EXPECT_EQ(chain.vector(), 0x12);
+    chain.acknowledge();
+    EXPECT_FALSE(chain.pending());
+
+    chain.request_nmi();
+    EXPECT_TRUE(chain.nmi_pending());
+    EXPECT_FALSE(chain.int_pending());
+}
+
+TEST(CtcTest, TimerCountsDownFromClock) {
+    scheduler clock;
+    interrupt_chain chain;
+    ctc timer(clock, chain);
+
+    // Channel 1: timer, prescaler 16, time constant 100 follows.
+    timer.write(1, ctc::control | ctc::time_constant_follows);
+    timer.write(1, 100);
+    EXPECT_EQ(timer.read(1), 100);
+
+    clock.advance(16 * 10);
+    EXPECT_EQ(timer.read(1), 90);
+    clock.advance(16 * 93);
+    EXPECT_EQ(timer.read(1), 97) << "Reloads from the time constant at zero";
+    EXPECT_FALSE(clock.due()) << "No interrupts, nothing scheduled";
+
+    // Reset stops the channel at its time constant.
+    timer.write(1, ctc::control | ctc::reset);
+    clock.advance(16 * 50);
+    EXPECT_EQ(timer.read(1), 100);
+
+    // Counter mode has no clock input.
+    timer.write(2, ctc::control | ctc::counter_mode | ctc::time_constant_follows);
+    timer.write(2, 7);
+    clock.advance(10000);
+    EXPECT_EQ(timer.read(2), 7);
+
+    timer.write(0, 0x48);
+    EXPECT_EQ(timer.vector(), 0x48);
+}
+
+TEST(CtcTest, ZeroCountRequestsInterrupt) {
+    scheduler clock;
+    interrupt_chain chain;
+    ctc timer(clock, chain);
+
+    timer.write(0, 0x40);   // Vector.
+    // Channel 2: timer with interrupts, prescaler 256, time constant 4.
+    timer.write(2, ctc::control | ctc::interrupt_enable | ctc::prescaler_256 |
+                   ctc::time_constant_follows);
+    timer.write(2, 4);
+    EXPECT_EQ(clock.next(), 1024u);
+
+    clock.advance(1030);
+    ASSERT_TRUE(clock.due());
+    clock.run_due();
+    ASSERT_TRUE(chain.int_pending());
+    EXPECT_EQ(chain.vector(), 0x44) << "Vector + 2 * channel";
+    chain.acknowledge();
+    EXPECT_EQ(clock.next(), 2048u) << "Re-armed for the next zero count";
+
+    // Disabling interrupts cancels the event.
+    timer.write(2, ctc::control | ctc::prescaler_256);
+    clock.advance(5000);
+    if (clock.due())
+        clock.run_due();
+    EXPECT_FALSE(chain.pending());
+}
+
+TEST(CtcTest, LoadRestoresChannelsAndTimers) {
+    scheduler clock;
+    interrupt_chain chain;
+    ctc timer(clock, chain);
+
+    timer.write(0, 0x40);
+    timer.write(1, ctc::control | ctc::interrupt_enable | ctc::time_constant_follows);
+    timer.write(1, 10);
+    clock.advance(100);
+    std::vector<uint8_t> saved;
+    state_writer out(saved);
+    timer.save(out);
+    chain.save(out);
+    const uint8_t count = timer.read(1);
+
+    // Run past a zero count and reprogram the channel, then go back.
+    clock.advance(200);
+    clock.run_due();
+    timer.write(1, ctc::control | ctc::reset);
+    clock.set_now(100);
+    state_reader in(saved);
+    timer.load(in);
+    chain.load(in);
+    EXPECT_TRUE(in.ok());
+    EXPECT_EQ(in.remaining(), 0u);
+    EXPECT_FALSE(chain.pending()) << "The request came after the save";
+    EXPECT_EQ(timer.read(1), count);
+    EXPECT_EQ(clock.next(), 160u) << "Zero count timer re-armed";
+
+    // A short stream loads zeroes and says so.
+    state_reader truncated(saved.data(), 3);
+    timer.load(truncated);
+    EXPECT_FALSE(truncated.ok());
+}
+
+TEST(PlatformTest, ProfilesAreConsistent) {
+    ASSERT_FALSE(profiles().empty());
+    EXPECT_EQ(profiles().front()->name, "none");
+    EXPECT_EQ(find_profile("partner"), &partner::machine());
+    EXPECT_EQ(find_profile("spectrum"), nullptr);
+    EXPECT_EQ(find_device_type("ctc"), device_type::ctc);
+    EXPECT_FALSE(find_device_type("pio"));
+
+    auto aligned = [](const memory_range &r) {
+        return r.size && !(r.address & 0xFFF) && !(r.size & 0xFFF) &&
+               r.address + r.size <= 0x10000;
+    };
+    for (const profile *p : profiles())
+    {
+        SCOPED_TRACE(std::string(p->name));
+        EXPECT_GT(p->clock_hz, 0u);
+        EXPECT_GE(p->banks, 1u);
+        if (p->rom) {
+            EXPECT_TRUE(aligned(*p->rom));
+        }
+
+        // Every window and device needs ports of its own.
+        std::bitset<256> ports;
+        auto claim = [&](unsigned first, unsigned count) {
+            for (unsigned port = first; port < first + count; ++port)
+            {
+                EXPECT_LT(port, 256u);
+                EXPECT_FALSE(ports.test(port % 256)) << "Port " << port << " is shared";
+                ports.set(port % 256);
+            }
+        };
+        for (const auto &w : p->windows)
+        {
+            EXPECT_TRUE(aligned(w.range));
+            claim(w.port, 1);
+        }
+        for (const auto &d : p->devices)
+            claim(d.port, d.type == device_type::ctc ? ctc::port_count : sio::port_count);
+    }
+}
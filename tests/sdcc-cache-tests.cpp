@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <sdcc/cdb_parser.h>
+#include <sdcc/map_parser.h>
+#include <sdcc/debug_cache.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace sdcc;
+
+namespace {
+
+debug_info parse_ura() {
+    debug_info info;
+    cdb_parser cdb;
+    auto modules = cdb.parse("tests/data/ura.cdb");
+    info.has_cdb = modules.has_value();
+    if (modules) info.modules = std::move(*modules);
+    map_parser map;
+    auto map_data = map.parse("tests/data/ura.map");
+    info.has_map = map_data.has_value();
+    if (map_data) info.map = std::move(*map_data);
+    return info;
+}
+
+} // namespace
+
+TEST(DebugCacheTest, RoundTrip) {
+    std::string cache_path = "tests/data/ura.dbgcache";
+    auto info = parse_ura();
+    ASSERT_TRUE(info.has_cdb && info.has_map);
+
+    debug_cache cache(cache_path);
+    ASSERT_TRUE(cache.save(info, "tests/data/ura.cdb", "tests/data/ura.map"));
+    auto loaded = cache.load("tests/data/ura.cdb", "tests/data/ura.map");
+    std::filesystem::remove(cache_path);
+    ASSERT_TRUE(loaded.has_value()) << "Cache should load while sources are unchanged";
+
+    EXPECT_TRUE(loaded->has_cdb);
+    EXPECT_TRUE(loaded->has_map);
+    ASSERT_EQ(loaded->modules.size(), info.modules.size());
+    for (size_t i = 0; i < info.modules.size(); ++i) {
+        const auto& a = info.modules[i];
+        const auto& b = loaded->modules[i];
+        EXPECT_EQ(a.name, b.name);
+        EXPECT_EQ(a.file, b.file);
+        ASSERT_EQ(a.functions.size(), b.functions.size());
+        for (size_t f = 0; f < a.functions.size(); ++f) {
+            EXPECT_EQ(a.functions[f].name, b.functions[f].name);
+            EXPECT_EQ(a.functions[f].stack, b.functions[f].stack);
+            EXPECT_EQ(a.functions[f].start, b.functions[f].start);
+            EXPECT_EQ(a.functions[f].end, b.functions[f].end);
+            EXPECT_EQ(a.functions[f].local_symbols.size(), b.functions[f].local_symbols.size());
+        }
+        EXPECT_EQ(a.global_symbols.size(), b.global_symbols.size());
+        EXPECT_EQ(a.types.size(), b.types.size());
+        ASSERT_EQ(a.lines.size(), b.lines.size());
+        for (size_t l = 0; l < a.lines.size(); ++l) {
+            EXPECT_EQ(a.lines[l].file, b.lines[l].file);
+            EXPECT_EQ(a.lines[l].line, b.lines[l].line);
+            EXPECT_EQ(a.lines[l].address, b.lines[l].address);
+        }
+    }
+    ASSERT_EQ(loaded->map.segments.size(), info.map.segments.size());
+    ASSERT_EQ(loaded->map.symbols.size(), info.map.symbols.size());
+    EXPECT_EQ(loaded->map.symbols.back().name, info.map.symbols.back().name);
+    EXPECT_EQ(loaded->map.symbols.back().address, info.map.symbols.back().address);
+}
+
+TEST(DebugCacheTest, StaleWhenSourceChanges) {
+    std::string cdb_path = "tests/data/stale.cdb";
+    std::string cache_path = "tests/data/stale.dbgcache";
+    {
+        std::ofstream out(cdb_path);
+        out << "M:clock\n";
+    }
+
+    debug_info info;
+    info.has_cdb = true;
+    info.modules.push_back({"clock", "clock.c", {}, {}, {}, {}});
+
+    debug_cache cache(cache_path);
+    ASSERT_TRUE(cache.save(info, cdb_path, ""));
+    EXPECT_TRUE(cache.load(cdb_path, "").has_value());
+
+    // A MAP file that wasn't there when the cache was written.
+    EXPECT_FALSE(cache.load(cdb_path, "tests/data/ura.map").has_value());
+
+    {
+        std::ofstream out(cdb_path, std::ios::app);
+        out << "M:screen\n";
+    }
+    EXPECT_FALSE(cache.load(cdb_path, "").has_value()) << "Cache should miss after the CDB changed";
+
+    std::filesystem::remove(cdb_path);
+    std::filesystem::remove(cache_path);
+}
+
+TEST(DebugCacheTest, TouchedSourceIsRestamped) {
+    std::string cdb_path = "tests/data/touched.cdb";
+    std::string cache_path = "tests/data/touched.dbgcache";
+    {
+        std::ofstream out(cdb_path);
+        out << "M:clock\n";
+    }
+
+    debug_info info;
+    info.has_cdb = true;
+    info.modules.push_back({"clock", "clock.c", {}, {}, {}, {}});
+
+    debug_cache cache(cache_path);
+    ASSERT_TRUE(cache.save(info, cdb_path, ""));
+    auto touched = std::filesystem::last_write_time(cdb_path) + std::chrono::seconds(10);
+    std::filesystem::last_write_time(cdb_path, touched);
+    EXPECT_TRUE(cache.load(cdb_path, "").has_value()) << "Same content should still hit";
+
+    // The CDB stamp follows magic, version and byte order; its mtime
+    // follows the exists flag and the size.
+    std::ifstream in(cache_path, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    int64_t recorded = 0;
+    content.str().copy(reinterpret_cast<char*>(&recorded), sizeof(recorded), 8 + 4 + 4 + 1 + 8);
+    EXPECT_EQ(recorded, static_cast<int64_t>(touched.time_since_epoch().count()))
+        << "Load should record the new modification time";
+
+    std::filesystem::remove(cdb_path);
+    std::filesystem::remove(cache_path);
+}
@@ -133,10 +133,10 @@ TEST(CdbParserTest, ParseDataConsistency) {
     auto result = parser.parse(cdb_path);
     ASSERT_TRUE(result.has_value()) << "Failed to parse ura.cdb";
     
-    const auto& modules = parser.data();
+    const auto& modules = result.value();
     
-    // Verify data() returns the same data as parse()
-    EXPECT_EQ(modules.size(), result.value().size()) << "data() should return same modules as parse()";
+    // parse() moves its result out rather than copying it
+    EXPECT_TRUE(parser.data().empty()) << "data() should be empty after parse() hands the result over";
     
     // Allow 6 modules due to observed output
     EXPECT_GE(modules.size(), 5) << "Expected at least 5 modules (e.g., clock, screen, trig, poly, sprite)";
@@ -157,4 +157,69 @@ TEST(CdbParserTest, ParseDataConsistency) {
     EXPECT_GE(total_local_symbols, 5) << "Expected at least 5 local symbols (e.g., hour, minute)";
     EXPECT_GE(total_types, 5) << "Expected at least 5 types (e.g., dim_s, point_s)";
     EXPECT_GE(total_lines, 10) << "Expected at least 10 line entries";
-}
\ No newline at end of file
+}
+
+TEST(CdbParserTest, ParseFunctionRanges) {
+    std::string cdb_path = "tests/data/ura.cdb";
+    ASSERT_TRUE(std::filesystem::exists(cdb_path)) << "Test file ura.cdb not found";
+
+    cdb_parser parser;
+    auto result = parser.parse(cdb_path);
+    ASSERT_TRUE(result.has_value()) << "Failed to parse ura.cdb";
+
+    auto find_function = [&](const std::string& module_name,
+                             const std::string& name) -> const cdbg_info_function* {
+        for (const auto& module : result.value()) {
+            if (module.name != module_name) continue;
+            for (const auto& func : module.functions) {
+                if (func.name == name) return &func;
+            }
+        }
+        return nullptr;
+    };
+
+    // F:G$clock_loop$0_0$0({2}DF,SV:S),Z,0,-6,0,0,0
+    // L:G$clock_loop$0$0:183 / L:XG$clock_loop$0$0:3B2
+    const auto* clock_loop = find_function("clock", "clock_loop");
+    ASSERT_NE(clock_loop, nullptr) << "Function clock_loop not found";
+    EXPECT_EQ(clock_loop->stack, -6);
+    EXPECT_FALSE(clock_loop->interrupt);
+    EXPECT_TRUE(clock_loop->has_range);
+    EXPECT_EQ(clock_loop->start, 0x183);
+    EXPECT_EQ(clock_loop->end, 0x3B2);
+
+    // Static function: F:Fscreen$_rotate$0_0$0(...),C,0,-10,0,0,0
+    const auto* rotate = find_function("screen", "_rotate");
+    ASSERT_NE(rotate, nullptr) << "Function _rotate not found";
+    EXPECT_EQ(rotate->scope, "local");
+    EXPECT_EQ(rotate->stack, -10);
+    EXPECT_TRUE(rotate->has_range);
+    EXPECT_EQ(rotate->start, 0x567);
+    EXPECT_EQ(rotate->end, 0x717);
+}
+
+TEST(CdbParserTest, ParseCrlfWithoutTrailingNewline) {
+    std::string cdb_file = "tests/data/crlf.cdb";
+    std::ofstream out(cdb_file, std::ios::binary);
+    out << "M:clock\r\n"
+           "F:G$clock_init$0_0$0({2}DF,SV:S),Z,0,-2,0,0,0\r\n"
+           "L:C$clock.c$18$0_0$36:116\r\n"
+           "L:G$clock_init$0$0:110";
+    out.close();
+
+    cdb_parser parser;
+    auto result = parser.parse(cdb_file);
+    std::filesystem::remove(cdb_file);
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->size(), 1u);
+    const auto& module = result->front();
+    EXPECT_EQ(module.name, "clock");
+    ASSERT_EQ(module.lines.size(), 1u);
+    EXPECT_EQ(module.lines[0].line, 18);
+    EXPECT_EQ(module.lines[0].address, 0x116);
+    ASSERT_EQ(module.functions.size(), 1u);
+    EXPECT_EQ(module.functions[0].stack, -2);
+    EXPECT_TRUE(module.functions[0].has_range);
+    EXPECT_EQ(module.functions[0].start, 0x110);
+}
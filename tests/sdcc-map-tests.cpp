@@ -2,6 +2,7 @@
 #include <sdcc/map_parser.h>
 
 #include <filesystem>
+#include <fstream>
 #include <string>
 
 using namespace sdcc;
@@ -45,3 +46,68 @@ TEST(MapParserTest, ParseInvalidMapFile) {
     auto result = parser.parse("tests/data/does_not_exist.map");
     EXPECT_FALSE(result.has_value()) << "Parsing non-existent MAP should fail";
 }
+
+TEST(MapParserTest, ParseSegmentAndSymbolLines) {
+    std::string map_path = "tests/data/lines.map";
+    std::ofstream out(map_path);
+    out << ".  .ABS.        00000000    00000000 =    0. bytes (ABS,CON)\n"
+           "_DATA           0x3508      000006B3 =  1715. bytes (REL,CON)\n"
+           "      Value  Global         Global Defined In Module\n"
+           "     00000116  G$clock_init$0$0   clock\n"
+           "     00000400  l__STACK\r\n"
+           "     00000100  s__CODE  extra  tokens\n";
+    out.close();
+
+    map_parser parser;
+    auto result = parser.parse(map_path);
+    std::filesystem::remove(map_path);
+    ASSERT_TRUE(result.has_value());
+
+    ASSERT_EQ(result->segments.size(), 1u);
+    EXPECT_EQ(result->segments[0].name, "_DATA");
+    EXPECT_EQ(result->segments[0].address, 0x3508u);
+    EXPECT_EQ(result->segments[0].size, 0x6B3u);
+    EXPECT_EQ(result->segments[0].attributes, "REL,CON");
+
+    ASSERT_EQ(result->symbols.size(), 2u);
+    EXPECT_EQ(result->symbols[0].name, "G$clock_init$0$0");
+    EXPECT_EQ(result->symbols[0].address, 0x116u);
+    EXPECT_EQ(result->symbols[0].area, "clock");
+    EXPECT_EQ(result->symbols[1].name, "l__STACK");
+    EXPECT_EQ(result->symbols[1].area, "");
+}
+
+TEST(MapParserTest, RankStaticFunctionMarkers) {
+    map_parser parser;
+    auto result = parser.parse("tests/data/ura.map");
+    ASSERT_TRUE(result.has_value());
+
+    // Static functions start at F<module>$<fn>$0$0 and end at XF<module>$...
+    size_t ends = 0;
+    bool found_start = false;
+    for (const auto &sym : result->symbols) {
+        if (sym.name.starts_with("XF")) {
+            ++ends;
+            EXPECT_EQ(symbol_rank(sym.name), rank_none) << sym.name;
+        }
+        if (sym.name == "Fscreen$_rotate$0$0") {
+            found_start = true;
+            EXPECT_EQ(sym.address, 0x567u);
+            EXPECT_EQ(symbol_rank(sym.name), rank_debug);
+        }
+        if (sym.name == "XFscreen$_rotate$0$0") {
+            EXPECT_EQ(sym.address, 0x717u);
+        }
+    }
+    EXPECT_EQ(ends, 7u);
+    EXPECT_TRUE(found_start);
+
+    EXPECT_EQ(symbol_rank("G$clock_init$0$0"), rank_debug);
+    EXPECT_EQ(symbol_rank("XG$clock_init$0$0"), rank_none);
+    EXPECT_EQ(symbol_rank("C$screen.c$64$1_0$38"), rank_none);
+    EXPECT_EQ(symbol_rank("_clock_init"), rank_c);
+    EXPECT_EQ(symbol_rank("s__CODE"), rank_area);
+    EXPECT_EQ(symbol_rank("l__CODE"), rank_none);
+    EXPECT_EQ(symbol_rank("Fill"), rank_label);
+    EXPECT_EQ(symbol_rank("XOR_TABLE"), rank_label);
+}